@@ -0,0 +1,432 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mesh.h"
+#include "meshgen.h"
+#include "solver.h"
+using namespace std;
+
+
+// Times the construction of Mesh, the assembly of its system, every solver of
+// solver.h and checkEnergyBalance for meshes from MIN_UNKNOWNS to
+// max_unknowns volumes (ten times more each size), printing one JSON object
+// per measurement:
+//
+//   benchmark.exe [max_unknowns [mesh [solver]]]
+//
+// where mesh and solver restrict the run to the ones with that name. Each
+// measurement has its time in seconds (the best of the repetitions), the
+// unknowns solved per second and the peak resident memory of the process
+// while it ran, in MB. Solves also have the iterations, the split of their
+// time between setup and iterations and the estimated work (see
+// solve_stats.h) of the best repetition, and the energy balance of the
+// solution
+
+#define SOLVER_TOLERANCE 1e-6
+#define MIN_UNKNOWNS 100
+#define DEFAULT_MAX_UNKNOWNS 1000000
+// short measurements are repeated until they add up to this many seconds
+#define MIN_MEASURE_TIME 0.2
+#define MAX_REPETITIONS 50
+
+
+typedef void (*tSolver)(const tSparseSystem&, DoubleVector&, double, bool);
+
+// iterations of most solvers grow with the number of volumes along the mesh,
+// and the fill of factorizations with the number of neighbors
+enum MeshShape {line_mesh, plane_mesh, block_mesh};
+
+
+// solvers are skipped in meshes with more unknowns than their limit for that
+// shape, over which they would take too long or too much memory
+typedef struct _tBenchSolver
+{
+    const char *name;
+    tSolver solver;
+    int max_unknowns[3];
+} tBenchSolver;
+
+
+typedef struct _tBenchMesh
+{
+    const char *name;
+    int max_unknowns; // meshes with a vector per volume use much more memory
+    MeshShape shape;
+    // fills the mesh data for about n_unknowns volumes, returns how many
+    function<int(int n_unknowns)> build;
+    // new Mesh from the data built last
+    function<Mesh*()> create;
+} tBenchMesh;
+
+
+typedef struct _tMeasurement
+{
+    double time;
+    double peak_memory; // MB
+    int repetitions;
+} tMeasurement;
+
+
+static void SOR4 (const tSparseSystem &system, DoubleVector &solution,
+                  double tolerance, bool verbose)
+{
+    SOR(system, solution, tolerance, verbose);
+}
+
+
+static void SSOR4 (const tSparseSystem &system, DoubleVector &solution,
+                   double tolerance, bool verbose)
+{
+    SSOR(system, solution, tolerance, verbose);
+}
+
+
+// limits for line, plane and block meshes
+static const tBenchSolver SOLVERS[] = {
+    {"gaussSeidel",             gaussSeidel,             {1000,     10000,    10000}},
+    {"multicolorGaussSeidel",   multicolorGaussSeidel,   {1000,     10000,    10000}},
+    {"SOR",                     SOR4,                    {1000,     100000,   100000}},
+    {"SSOR",                    SSOR4,                   {1000,     10000,    100000}},
+    {"lineByLineTDMA",          lineByLineTDMA,          {10000000, 10000,    10000}},
+    {"conjugateGradientJacobi", conjugateGradientJacobi, {10000,    1000000,  1000000}},
+    {"conjugateGradientSSOR",   conjugateGradientSSOR,   {10000,    1000000,  1000000}},
+    {"conjugateGradientIC",     conjugateGradientIC,     {10000000, 10000000, 10000000}},
+    {"multigridV",              multigridV,              {10000000, 10000000, 10000000}},
+    {"multigridF",              multigridF,              {10000000, 10000000, 10000000}},
+    {"algebraicMultigrid",      algebraicMultigrid,      {10000000, 10000000, 10000}},
+    {"conjugateGradientAMG",    conjugateGradientAMG,    {10000000, 10000000, 10000}},
+    {"TDMA",                    TDMA,                    {10000000, 10000000, 10000000}},
+    {"sparseCholesky",          sparseCholesky,          {10000000, 1000000,  100000}}
+};
+
+
+static double now ()
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Peak resident memory of the process in MB. resetPeakMemory makes it start
+// again from the current one where the kernel allows it (Linux), otherwise
+// it is the peak since the process started
+static void resetPeakMemory ()
+{
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+
+    if (file)
+    {
+        fputs("5", file);
+        fclose(file);
+    }
+}
+
+
+static double peakMemory ()
+{
+    FILE *file = fopen("/proc/self/status", "r");
+
+    if (file)
+    {
+        char line[256];
+        long kb = -1;
+
+        while (fgets(line, sizeof(line), file))
+            if (strncmp(line, "VmHWM:", 6) == 0)
+                kb = atol(line + 6);
+
+        fclose(file);
+
+        if (kb >= 0)
+            return kb/1024.0;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss/1024.0;
+}
+
+
+// prepare is not timed, body is. Returns the best time of the repetitions.
+// on_best, if given, is called after each repetition that is the best so far,
+// to keep what body measured in it
+static tMeasurement measure (const function<void()> &prepare,
+                             const function<void()> &body,
+                             const function<void()> &on_best = nullptr)
+{
+    tMeasurement result;
+    result.time = -1;
+    result.peak_memory = 0;
+    result.repetitions = 0;
+
+    double total = 0;
+
+    while (total < MIN_MEASURE_TIME and result.repetitions < MAX_REPETITIONS)
+    {
+        prepare();
+        resetPeakMemory();
+
+        double start = now();
+        body();
+        double time = now() - start;
+
+        double memory = peakMemory();
+
+        if (result.time < 0 or time < result.time)
+        {
+            result.time = time;
+
+            if (on_best)
+                on_best();
+        }
+
+        if (memory > result.peak_memory)
+            result.peak_memory = memory;
+
+        total += time;
+        result.repetitions++;
+    }
+
+    return result;
+}
+
+
+static string jsonString (const string &text)
+{
+    string quoted = "\"";
+
+    for (int i = 0; i < text.size(); i++)
+    {
+        if (text[i] == '"' or text[i] == '\\')
+            quoted += '\\';
+
+        quoted += text[i];
+    }
+
+    return quoted + "\"";
+}
+
+
+// One line per measurement. extra holds more fields, already formatted
+static void report (const string &mesh, int n_unknowns, const string &phase,
+                    const string &solver, const tMeasurement *measurement,
+                    const string &extra, const string &error)
+{
+    ostringstream line;
+    line.precision(6);
+
+    line << "{\"mesh\": " << jsonString(mesh)
+         << ", \"unknowns\": " << n_unknowns
+         << ", \"phase\": " << jsonString(phase);
+
+    if (not solver.empty())
+        line << ", \"solver\": " << jsonString(solver);
+
+    if (measurement)
+        line << ", \"time\": " << measurement->time
+             << ", \"repetitions\": " << measurement->repetitions
+             << ", \"unknowns_per_s\": " << n_unknowns/measurement->time
+             << ", \"peak_memory_mb\": " << measurement->peak_memory;
+
+    line << extra;
+
+    if (not error.empty())
+        line << ", \"error\": " << jsonString(error);
+
+    line << "}";
+
+    cout << line.str() << endl;
+}
+
+
+static void noSolver (const tSparseSystem &system, DoubleVector &solution,
+                      double tolerance, bool verbose)
+{
+}
+
+
+static void benchmarkMesh (const tBenchMesh &bench_mesh, int n_unknowns,
+                           const string &solver_filter)
+{
+    const string name = bench_mesh.name;
+    unique_ptr<Mesh> mesh;
+
+    tMeasurement measurement = measure([&] () { mesh.reset(); },
+                                       [&] () { mesh.reset(bench_mesh.create()); });
+    report(name, n_unknowns, "construct", "", &measurement, "", "");
+
+    // solving with a solver that does nothing only assembles the system
+    measurement = measure([&] () { mesh.reset(bench_mesh.create()); },
+                          [&] ()
+    {
+        DoubleVector T;
+        mesh->solveMesh(noSolver, T, SOLVER_TOLERANCE);
+    });
+    report(name, n_unknowns, "assemble", "", &measurement, "", "");
+
+    DoubleVector solution;
+
+    for (const tBenchSolver &solver : SOLVERS)
+    {
+        if (not solver_filter.empty() and solver_filter != solver.name)
+            continue;
+
+        if (n_unknowns > solver.max_unknowns[bench_mesh.shape])
+        {
+            report(name, n_unknowns, "solve", solver.name, nullptr, "",
+                   "skipped, more unknowns than the limit of the solver");
+            continue;
+        }
+
+        DoubleVector T;
+        tSolveStats stats, best_stats;
+
+        try
+        {
+            // every repetition starts from zero in a new mesh, so the setups
+            // of the solver are built and timed each time
+            measurement = measure([&] ()
+            {
+                T.clear();
+                mesh.reset(bench_mesh.create());
+                mesh->solveMesh(noSolver, T, SOLVER_TOLERANCE);
+            },
+            [&] ()
+            {
+                mesh->solveMesh(solver.solver, T, SOLVER_TOLERANCE, false,
+                                false, &stats);
+            },
+            [&] () { best_stats = stats; });
+        }
+        catch (exception &e)
+        {
+            report(name, n_unknowns, "solve", solver.name, nullptr, "", e.what());
+            continue;
+        }
+
+        ostringstream extra;
+        extra.precision(6);
+        extra << ", \"iterations\": " << best_stats.iterations
+              << ", \"setup_time\": " << best_stats.setup_time
+              << ", \"iteration_time\": " << best_stats.solve_time
+              << ", \"flops\": " << best_stats.flops
+              << ", \"bytes\": " << best_stats.bytes
+              << ", \"energy_balance\": " << mesh->checkEnergyBalance(T);
+
+        report(name, n_unknowns, "solve", solver.name, &measurement,
+               extra.str(), "");
+
+        solution.swap(T);
+    }
+
+    if (solution.empty())
+        return;
+
+    measurement = measure([] () {}, [&] ()
+    {
+        mesh->checkEnergyBalance(solution);
+    });
+    report(name, n_unknowns, "energy_balance", "", &measurement, "", "");
+}
+
+
+int main (int argc, char *argv[])
+{
+    int max_unknowns = (argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_UNKNOWNS);
+    string mesh_filter = (argc > 2 and strcmp(argv[2], "all") != 0 ? argv[2] : "");
+    string solver_filter = (argc > 3 ? argv[3] : "");
+
+    tMeshData data;
+    tCompactMeshData compact_data;
+
+    // fin and test meshes have a vector per volume, grids are built as
+    // tCompactMeshData
+    function<Mesh*()> create_from_data = [&] () { return new Mesh(&data); };
+    function<Mesh*()> create_from_compact = [&] () { return new Mesh(&compact_data); };
+
+    auto build_grid = [&] (int n_dims, int n_unknowns)
+    {
+        int n = int(round(pow(double(n_unknowns), 1.0/n_dims)));
+
+        // steel block heated inside, fixed T on one side and convection on
+        // the others
+        tBoxParameters box;
+        box.problem_dimensions = n_dims;
+        box.lambda = 15;
+        box.qv = 1e4;
+        box.rho = 7900;
+        box.cp = 477;
+        box.boundary_data = DoubleMatrix({{fixed_T_boundary, 300, 0},
+                                          {convection_boundary, 293, 20}});
+
+        for (int d = 0; d < 3; d++)
+        {
+            box.n_cells[d] = (d < n_dims ? n : 1);
+            box.origin[d] = 0;
+            box.length[d] = 1;
+        }
+
+        for (int s = 0; s < 6; s++)
+            box.side_boundary[s] = (s == 0 ? 0 : 1);
+
+        buildCartesianMesh(compact_data, box);
+
+        return compact_data.n_volms;
+    };
+
+    vector<tBenchMesh> meshes = {
+        {"fin", 1000000, line_mesh, [&] (int n_unknowns)
+        {
+            tFinParameters fin = defaultFinParameters();
+            fin.n_elms = n_unknowns;
+            buildCylindricalFinMesh(data, fin);
+
+            return data.n_volms;
+        }, create_from_data},
+
+        {"test", 1000000, line_mesh, [&] (int n_unknowns)
+        {
+            buildTestMesh(data, n_unknowns);
+
+            return data.n_volms;
+        }, create_from_data},
+
+        {"grid2d", 10000000, plane_mesh, [&] (int n_unknowns)
+        {
+            return build_grid(2, n_unknowns);
+        }, create_from_compact},
+
+        {"grid3d", 10000000, block_mesh, [&] (int n_unknowns)
+        {
+            return build_grid(3, n_unknowns);
+        }, create_from_compact}
+    };
+
+    for (const tBenchMesh &bench_mesh : meshes)
+    {
+        if (not mesh_filter.empty() and mesh_filter != bench_mesh.name)
+            continue;
+
+        for (int size = MIN_UNKNOWNS; size <= max_unknowns and
+                                      size <= bench_mesh.max_unknowns; size *= 10)
+        {
+            int n_unknowns = bench_mesh.build(size);
+            benchmarkMesh(bench_mesh, n_unknowns, solver_filter);
+
+            data = tMeshData();
+            compact_data = tCompactMeshData();
+        }
+    }
+
+    return 0;
+}
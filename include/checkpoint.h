@@ -0,0 +1,57 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "mesh.h"
+
+
+// Stores state in path, in the binary format of meshio.h. The file is written
+// aside and then renamed, so path always holds a whole checkpoint, the new one
+// or the previous. Throws BinaryFileError if it can not be written
+void writeCheckpoint (const std::string &path, const tTransientState &state);
+
+// Throws BinaryFileError if path can not be read and BadBinaryFile if it does
+// not hold a checkpoint
+void readCheckpoint (const std::string &path, tTransientState &state);
+
+
+// Writes checkpoints to a file from a thread of its own. save only copies the
+// state, and if the previous checkpoint is still being written the new one
+// waits for it, replacing any other that was waiting, so the time steps never
+// wait for the disk
+class CheckpointWriter
+{
+public:
+
+    CheckpointWriter (const std::string &path);
+
+    // throws the error of a previous checkpoint, if any
+    void save (const tTransientState &state);
+
+    // waits for the checkpoint that is waiting or being written and throws
+    // its error, if any
+    void finish ();
+
+    ~CheckpointWriter ();
+
+private:
+
+    void writerLoop ();
+
+    std::string path_;
+    std::thread writer_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool has_pending_;
+    bool writing_;
+    bool finished_;
+    tTransientState pending_;
+    std::exception_ptr error_;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef CHOLESKY_H_
+#define CHOLESKY_H_
+
+#include <memory>
+#include "definitions.h"
+#include "sparse.h"
+
+
+// Order in which to eliminate the nodes of a symmetric system so that its
+// Cholesky factor has few coefficients: each step takes the node with fewest
+// neighbors in the graph left by the previous eliminations (minimum degree).
+// order[k] is the node eliminated in step k
+void minimumDegreeOrdering (const tSparseSystem &system, std::vector<int> &order);
+
+
+// Symbolic part of the sparse Cholesky factorization P*A*P^T = L*L^T of a
+// symmetric system, which only depends on the positions of its coefficients:
+// the minimum degree ordering P, the elimination tree and the positions of the
+// coefficients of L. It is structural, so it is kept in the cache of the
+// system while only the values of the coefficients change
+class CholeskySymbolic : public SolverSetup
+{
+public:
+
+    CholeskySymbolic (const tSparseSystem &system);
+
+    bool structural () const override { return true; }
+
+    int getNonZeros () const;
+
+    // Puts in pattern[top ... n_rows-1] the columns j < k of the coefficients
+    // of row k of L, each one after the ones it depends on. mark must have
+    // n_rows values different from k. Returns top
+    int rowPattern (const tSparseSystem &system, int k, std::vector<int> &pattern,
+                    std::vector<int> &mark) const;
+
+    // node eliminated in step k and step in which node i is eliminated
+    std::vector<int> perm;
+    std::vector<int> inv_perm;
+
+    // parent of each step in the elimination tree (-1 for roots)
+    std::vector<int> parent;
+
+    // L by columns, rows increasing and the diagonal the first one
+    std::vector<int> col_start;
+    std::vector<int> row_index;
+};
+
+
+// Numeric part of the factorization, for the values of the coefficients the
+// system had when it was built. Throws NotPositiveDefinite if a pivot is not
+// positive
+class CholeskyFactor : public SolverSetup
+{
+public:
+
+    CholeskyFactor (const tSparseSystem &system,
+                    const std::shared_ptr<const CholeskySymbolic> &symbolic);
+
+    // solves A*solution = rhs with two triangular solves
+    void solve (const DoubleVector &rhs, DoubleVector &solution) const;
+
+private:
+
+    std::shared_ptr<const CholeskySymbolic> symbolic_;
+    DoubleVector value_; // coefficients of L, same positions as row_index
+};
+
+#endif
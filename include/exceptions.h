@@ -85,4 +85,103 @@ struct BadQuantityOfAttributes : public std::exception
 };
 
 
+struct NotTridiagonalSystem : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The system has coefficients outside the three main diagonals";
+    }
+};
+
+
+struct NotStructuredSystem : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The system does not come from a structured mesh numbered in order";
+    }
+};
+
+
+struct NotPositiveDefinite : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The system is not symmetric positive definite";
+    }
+};
+
+
+struct BadRelaxationFactor : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The relaxation factor must be between 0 and 2";
+    }
+};
+
+
+struct MissingHeatCapacity : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "A volume has no density or specific heat for the time integration";
+    }
+};
+
+
+struct BadTransientParameters : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The time, steps or outputs of the transitory are not valid";
+    }
+};
+
+
+struct BadBoxParameters : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The parameters of the box to generate are not valid";
+    }
+};
+
+
+struct SinkNotStarted : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The sink received a snapshot before begin or after it stopped";
+    }
+};
+
+
+struct BadCheckpoint : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The checkpoint belongs to a different mesh or transitory";
+    }
+};
+
+
+struct BinaryFileError : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The binary file could not be read or written";
+    }
+};
+
+
+struct BadBinaryFile : public std::exception
+{
+	const char * what () const throw ()
+    {
+    	return "The binary file is not valid or lacks the arrays needed";
+    }
+};
+
+
 #endif
\ No newline at end of file
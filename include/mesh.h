@@ -1,8 +1,11 @@
 #ifndef MESH_H_
 #define MESH_H_
 
-#include "volume.h"
+#include <string>
 #include "definitions.h"
+#include "solve_stats.h"
+#include "sparse.h"
+#include "transient_sink.h"
 
 
 typedef struct _tMeshData
@@ -20,7 +23,8 @@ typedef struct _tMeshData
     DoubleMatrix surface_volumes;
     DoubleMatrix connectivity_volumes;
 
-    // for each node: volume, lambda, qv
+    // for each node: volume, lambda, qv, rho, cp
+    // rho and cp are only needed for transitory problems and can be left out
     DoubleMatrix volms_data;
 
     // for each boundary: type (VType value), T_ext/T, alpha/distance
@@ -29,20 +33,112 @@ typedef struct _tMeshData
 } tMeshData;
 
 
+// implicit Euler is first order and never oscillates, Crank-Nicolson is second
+// order but can oscillate with time steps that are too long. The explicit
+// schemes (forward Euler, first order, and Heun's RK2, second order) need no
+// solver but are only stable for short time steps, see Mesh::stableTimeStep
+enum TimeScheme {implicit_euler, crank_nicolson, explicit_euler, explicit_rk2};
+
+
+// Everything needed to continue a transitory from the end of one of its time
+// steps exactly as if it had not stopped (see Mesh::setCheckpoints). The
+// setups of the solvers are not included, they are built again from the same
+// coefficients and give the same results
+typedef struct _tTransientState
+{
+    bool adaptive;     // solveTransitoryAdaptive or solveTransitory
+    TimeScheme scheme; // of solveTransitory
+    double t;          // total simulation time
+    double tolerance;  // of the solver
+
+    // solveTransitory: steps done of time_steps
+    int step;
+    int time_steps;
+    int store_each;
+
+    // solveTransitoryAdaptive: time reached, next time step, outputs given
+    // and steps accepted and rejected
+    double time;
+    double h;
+    double time_tolerance;
+    int n_outputs;
+    int next_output;
+    int n_steps;
+    int n_rejected;
+
+    // hash of the coefficients and heat capacities of the mesh, 0 if unknown
+    unsigned long long fingerprint;
+
+    DoubleVector T; // temperatures at the end of the last step
+} tTransientState;
+
+class CheckpointWriter;
+
+
+// Same data as tMeshData in flat arrays, without a vector per volume, as built
+// by the generators of meshgen.h. The values of volume i are the ones at
+// i*width ... (i+1)*width-1 of each array
+typedef struct _tCompactMeshData
+{
+    unsigned int problem_dimensions;
+    int n_volms;
+    int n_boundaries;
+
+    DoubleVector pos_volumes;              // width problem_dimensions
+    DoubleVector surface_volumes;          // width 2*problem_dimensions
+    std::vector<int> connectivity_volumes; // width 2*problem_dimensions
+
+    // volume, lambda, qv, rho, cp (width 5, all of them needed)
+    DoubleVector volms_data;
+
+    // type, T_ext/T, alpha/distance (width 3)
+    DoubleVector boundary_data;
+} tCompactMeshData;
+
+
+// Arrays of a tCompactMeshData stored elsewhere, like in a mapped file (see
+// meshio.h). They only need to live while the Mesh is built
+typedef struct _tMeshView
+{
+    unsigned int problem_dimensions;
+    int n_volms;
+    int n_boundaries;
+
+    const double *pos_volumes;
+    const double *surface_volumes;
+    const int *connectivity_volumes;
+    const double *volms_data;
+    const double *boundary_data;
+} tMeshView;
+
+// view of the arrays of mesh, which must have the right sizes
+tMeshView meshView (const tCompactMeshData &mesh);
+
+
 class Mesh
 {
 public:
 
     Mesh (const tMeshData *mesh);
+    Mesh (const tCompactMeshData *mesh);
+    Mesh (const tMeshView &mesh);
 
     int getNumVolumes () const;
     int getNumBoundaries () const;
 
     // node_data and boundary_data must follow the same format as the one
-    // from tMeshData and be of corresponding lenght
+    // from tMeshData and be of corresponding lenght. The values are updated in
+    // place and only the equations of the volumes affected by a change are
+    // assembled again in the next solve. If only independent terms change
+    // (boundary temperatures, qv...) the setups of the solvers are kept
     void setNodeData (const DoubleMatrix &node_data);
     void setBoundaryData (const DoubleMatrix &boundary_data);
 
+    // Changes the conductivity of volume index. Only the conductances of the
+    // faces that touch it are recomputed and the next solve will assemble the
+    // system with them
+    void setLambda (int index, double new_lambda);
+
     // The ith position of T contains the temperature of the ith volume.
     // T must be a 1D vector of size n_nodes and solver the name of a solver from
     // solver.h. If the selected solver has machine precission and no tolerance
@@ -52,22 +148,116 @@ public:
     // the returned value is the one further away from zero, if check_solution = false
     // the returned value is always zero.
     // If verbose = true, the solver will output information about the progress.
-    double solveMesh (void(*solver)(const DoubleMatrix&, DoubleVector&, double, bool),
+    // If T already has n_nodes values iterative solvers start from them, and
+    // otherwise from the solution of the previous solve of the mesh, if any.
+    // If stats is given it is reset and filled with the iterations, times and
+    // work of this solve (see solve_stats.h)
+    double solveMesh (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
                       DoubleVector &T, double tolerance,
-                      bool check_solution = false, bool verbose = false);
+                      bool check_solution = false, bool verbose = false,
+                      tSolveStats *stats = nullptr);
+
+    // Solves the mesh for each one of the sets of boundaries in boundary_data
+    // (each one with the format of tMeshData) and stores in T[s] the
+    // temperatures of set s. The mesh itself is not changed. Sets that only
+    // differ in their temperatures share the matrix of the system and its
+    // incomplete Cholesky factorization and are solved in blocks with
+    // blockConjugateGradient (see solver.h). Different matrices and blocks are
+    // solved in parallel in the threads of defaultThreadPool
+    void solveMeshBatch (const std::vector<DoubleMatrix> &boundary_data,
+                         DoubleMatrix &T, double tolerance, bool verbose = false);
 
     // T0 must be a 1D vector of length n_nodes detailing the initial conditions,
     // T must be a 2D vector of size time_steps/store_each x n_nodes and
     // it stores the temperature of all the nodes each store_each timesteps,
     // time_steps is the quantity of time iterations from 0 to t, t is the total
     // simulation time and store_each indicates each how many time_steps the
-    // temperature data is stored
-    void solveTransitory (const DoubleVector &T0,
+    // temperature data is stored. T is only resized if its size is not the
+    // right one.
+    // Each time step solves one system with solver (as in solveMesh), starting
+    // from the temperatures of the previous step. Its coefficients are the same
+    // in all the steps, so the setups of the solver are built in the first one
+    // and reused, also by later calls with the same time step and scheme. The
+    // volumes need rho and cp in volms_data (MissingHeatCapacity otherwise),
+    // and t, time_steps and store_each must be positive (BadTransientParameters
+    // otherwise).
+    // The explicit schemes do not use solver nor tolerance (solver can be
+    // nullptr) and split each time step into as many equal sub-steps as needed
+    // to stay below stableTimeStep.
+    // If verbose = true the progress of each time step is printed
+    void solveTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                          const DoubleVector &T0,
                           DoubleMatrix &T,
                           int time_steps,
                           double t,
-                          int store_each);
+                          int store_each,
+                          double tolerance,
+                          TimeScheme scheme = implicit_euler,
+                          bool verbose = false);
+
+    // Same but each stored row is given to sink as soon as it is computed
+    // instead of being kept in memory (see transient_sink.h)
+    void solveTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                          const DoubleVector &T0,
+                          TransientSink &sink,
+                          int time_steps,
+                          double t,
+                          int store_each,
+                          double tolerance,
+                          TimeScheme scheme = implicit_euler,
+                          bool verbose = false);
     
+    // Same as solveTransitory but with a time step that changes along the
+    // simulation to keep the local error of each step below time_tolerance (in
+    // K, for all the nodes), with the TR-BDF2 scheme (second order and without
+    // oscillations). T is resized to n_outputs x n_nodes and row k holds the
+    // temperatures at (k+1)*t/n_outputs, interpolated within the steps, so the
+    // outputs do not limit the length of the steps. tolerance is the one of
+    // solver. The setups of solver are rebuilt only when the time step
+    // changes. t, n_outputs and time_tolerance must be positive. Returns the
+    // number of time steps
+    int solveTransitoryAdaptive (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                                 const DoubleVector &T0,
+                                 DoubleMatrix &T,
+                                 double t,
+                                 int n_outputs,
+                                 double tolerance,
+                                 double time_tolerance,
+                                 bool verbose = false);
+
+    int solveTransitoryAdaptive (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                                 const DoubleVector &T0,
+                                 TransientSink &sink,
+                                 double t,
+                                 int n_outputs,
+                                 double tolerance,
+                                 double time_tolerance,
+                                 bool verbose = false);
+
+    // Every each_steps time steps (accepted ones in solveTransitoryAdaptive)
+    // the next transitories store their state in the file path, from another
+    // thread so that the steps do not wait for it, and a transitory that
+    // stops can be continued with resumeTransitory. The sink is flushed before
+    // each checkpoint, so the rows it counts are never lost. The file always
+    // holds the last checkpoint that was written whole. each_steps = 0
+    // disables them
+    void setCheckpoints (const std::string &path, int each_steps);
+
+    // Continues the transitory of the checkpoint in path with the same
+    // parameters it had, giving sink only the rows that had not been stored
+    // yet, and obtaining the same temperatures as if it had not stopped.
+    // The data of the mesh must be the same (throws BadCheckpoint otherwise).
+    // Returns the number of time steps of the whole transitory
+    int resumeTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                          const std::string &path,
+                          TransientSink &sink,
+                          bool verbose = false);
+
+    // Longest time step for which the explicit schemes are stable, C_i/a_ii
+    // for the most restrictive volume. Throws MissingHeatCapacity if a volume
+    // has no rho or cp
+    double stableTimeStep () const;
+
     // from and to indicate the node index that will be printed
     // set to = -1 to print until the last node
     void printMesh (int from, int to, bool only_volumes = true) const;
@@ -79,14 +269,135 @@ public:
     // better solutions)
     double checkEnergyBalance (const DoubleVector &T) const;
 
-    ~Mesh ();
 private:
 
+    // Builds everything about the faces from face_neighbor_ and the data of
+    // the volumes and boundaries, once they are copied by the constructors
+    void buildFaces ();
+
+    // Appends to system the equation of every volume, with the format
+    // sum(a_i * x_i) = b_i. The boundaries are the ones of the mesh or, if
+    // given, the ones in boundary_data (same format as in tMeshData)
+    void assemble (tSparseSystem &system,
+                   const DoubleMatrix *boundary_data = nullptr) const;
+
+    // conductance of a face to a boundary with the given data (type, T,
+    // alpha/distance) instead of the one of the mesh
+    double boundaryConductance (int face, const DoubleVector &data) const;
+
+    // The equation of volume i must be assembled again
+    void markDirty (int i);
+
+    // Brings system_ up to date with the data of the mesh, assembling it the
+    // first time and then only the dirty rows. The setups of the solvers are
+    // discarded if any coefficient changed
+    void updateSystem ();
+
+    // Recomputes in place row i of a system assembled by assemble. Returns
+    // true if any of its coefficients changed
+    bool updateRow (tSparseSystem &system, int i) const;
+
+    // rho*cp*volume of each volume, energy needed to raise its temperature 1 K.
+    // Throws MissingHeatCapacity if a volume has no rho or cp
+    void heatCapacities (DoubleVector &capacity) const;
+
+    // geometric part of the conductance of a face: S/d for faces between
+    // volumes and with fixed T boundaries, S for convection boundaries
+    double faceGeometry (int face) const;
+
+    // conductance of a face from its geometric part and the current lambda or
+    // alpha (harmonic mean of lambda between solid volumes)
+    double faceConductance (int face) const;
+
+    // distance between the centers of two volumes
+    double distance (int i, int j) const;
+
+    void printBoundary (int index) const;
+
+    double stableTimeStep (const tSparseSystem &steady,
+                           const DoubleVector &capacity) const;
+
+    // Puts C + factor*A into transient_system_, where C is the diagonal matrix
+    // of the heat capacities and A the matrix of steady
+    void setStepSystem (const tSparseSystem &steady,
+                        const DoubleVector &capacity, double factor);
+
+    // dT = C^-1*(b - A*T)
+    void timeDerivative (const tSparseSystem &steady,
+                         const DoubleVector &capacity,
+                         const DoubleVector &T, DoubleVector &dT) const;
+
+    // Time steps of solveTransitory and solveTransitoryAdaptive from the ones
+    // already done in state, which is kept up to date. Return the number of
+    // time steps
+    int runTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                       tTransientState &state, TransientSink &sink,
+                       bool verbose);
+
+    int runTransitoryAdaptive (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                               tTransientState &state, TransientSink &sink,
+                               bool verbose);
+
+    // steps of the explicit schemes, checkpoints is nullptr if they are
+    // disabled
+    void explicitTransitory (const tSparseSystem &steady,
+                             const DoubleVector &capacity,
+                             tTransientState &state, TransientSink &sink,
+                             CheckpointWriter *checkpoints, bool verbose) const;
+
+    // Hash of the coefficients and heat capacities of a transitory, to check
+    // that a checkpoint belongs to this mesh
+    unsigned long long transientFingerprint (const tSparseSystem &steady,
+                                             const DoubleVector &capacity) const;
+
     int n_volumes;
     int n_boundaries;
     unsigned int problem_dim_;
+    int n_faces_; // of each volume, two per dimension
+
+    // data of the volumes, one entry per volume
+    DoubleVector volume_;
+    DoubleVector lambda_;
+    DoubleVector qv_;
+    DoubleVector rho_;
+    DoubleVector cp_;
+    DoubleVector position_; // problem_dim_ entries per volume
+    DoubleVector surface_;  // one entry per face
+
+    // data of the boundaries, boundary b is the node n_volumes+b
+    std::vector<VType> boundary_type_;
+    DoubleVector boundary_T_;           // T_ext or T
+    DoubleVector boundary_coefficient_; // alpha or distance
+
+    // faces of volume i are i*n_faces_ ... (i+1)*n_faces_-1, in the order of
+    // connectivity_volumes. The neighbor is the index of the node on the
+    // other side and the kind is solid for faces between volumes and the type
+    // of the boundary otherwise
+    std::vector<int> face_neighbor_;
+    std::vector<VType> face_kind_;
+    // conductances are computed once from their geometric part and only the
+    // ones affected by a change of the data are recomputed
+    DoubleVector face_geometry_;
+    DoubleVector face_conductance_;
+
+    // faces of boundary b are boundary_face_[boundary_face_start_[b]] ...
+    // boundary_face_[boundary_face_start_[b+1]-1]
+    std::vector<int> boundary_face_start_;
+    std::vector<int> boundary_face_;
+
+    // system of the last solve, kept so that solvers can reuse their setups
+    // and only the equations of the volumes whose data changed are updated
+    tSparseSystem system_;
+    DoubleVector last_solution_;
+    bool assembled_;
+    std::vector<char> is_dirty_;
+    std::vector<int> dirty_rows_;
+    // same for the system of each time step of the last transitory
+    tSparseSystem transient_system_;
 
-    std::vector<Volume*> node; // array with all the nodes
+    // see setCheckpoints
+    std::string checkpoint_path_;
+    int checkpoint_each_;
 };
 
 #endif
\ No newline at end of file
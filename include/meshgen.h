@@ -0,0 +1,103 @@
+#ifndef MESHGEN_H_
+#define MESHGEN_H_
+
+#include "mesh.h"
+
+
+// parameters of an annular fin of constant thickness around a tube
+typedef struct _tFinParameters
+{
+    double Ra;     // inner radius (joint with the tube)
+    double Rb;     // outer radius
+    double e;      // thickness
+    double Ta;     // temperature of the tube
+    double Tg;     // temperature of the surrounding gas
+    double lambda;
+    double rho;
+    double cp;
+    double alpha;  // convection coefficient of the upper and lower surfaces
+    int n_elms;    // volumes along the radius
+} tFinParameters;
+
+
+// steel fin of 5 to 13 cm in air
+tFinParameters defaultFinParameters ();
+
+// 1D mesh along the radius of the fin with three boundaries: the tube
+// (fixed T, node n_elms), the upper and lower surfaces (convection, node
+// n_elms+1) and the tip (adiabatic, node n_elms+2)
+void buildCylindricalFinMesh (tMeshData &mesh, const tFinParameters &fin);
+
+// 2D row of n_volms volumes along x, 1 m high and 1, 2 or 3 m wide, with a
+// fixed T boundary at the left end (node n_volms), convection boundaries of
+// their own below and above each volume (nodes n_volms+1 ... n_volms+2*n_volms)
+// and an adiabatic right end (last node). The data of the volumes and
+// boundaries repeats every three volumes
+void buildTestMesh (tMeshData &mesh, int n_volms = 3);
+
+
+// block of cells of a box with a material different from the rest, cells
+// begin[d] ... end[d]-1 along each axis d
+typedef struct _tBoxRegion
+{
+    int begin[3];
+    int end[3];
+    double lambda;
+    double qv;
+    double rho;
+    double cp;
+} tBoxRegion;
+
+
+// part of a side of a box with a boundary different from the rest of the side,
+// the faces on that side of the cells in the block (the range of the axis of
+// the side is not used)
+typedef struct _tBoxPatch
+{
+    int side; // 2*d for the lower end of axis d and 2*d+1 for the upper one
+    int begin[3];
+    int end[3];
+    int boundary;
+} tBoxPatch;
+
+
+// Box divided in cells of the same size along each axis. Volume i is the cell
+// (a, b, c) with i = a + n_cells[0]*(b + n_cells[1]*c), and its faces follow
+// the order of the sides (see tBoxPatch), as needed by lineByLineTDMA and
+// multigridV. The axes are x, y, z for cartesian boxes and r, z (revolution
+// around the z axis) or r, theta, z for cylindrical ones. A 3D cylindrical box
+// of a whole turn links the first and last cells along theta, which those two
+// solvers do not support (they throw NotStructuredSystem), so its systems
+// need one of the others
+typedef struct _tBoxParameters
+{
+    unsigned int problem_dimensions; // 2 or 3
+    int n_cells[3];
+    double origin[3];
+    double length[3]; // theta in radians, a whole turn closes the ring
+
+    // material of the cells outside every region, regions listed later win
+    // where they overlap
+    double lambda;
+    double qv;
+    double rho;
+    double cp;
+    std::vector<tBoxRegion> regions;
+
+    // boundary_data has the format of tMeshData and side_boundary the row of
+    // the boundary of each side, unless a patch says otherwise. Fixed T
+    // boundaries with distance 0 get half the width of the cells of the first
+    // side that uses them
+    DoubleMatrix boundary_data;
+    int side_boundary[6];
+    std::vector<tBoxPatch> patches;
+} tBoxParameters;
+
+
+// Fill mesh with the cells of box, working directly on its arrays (and in
+// parallel in the threads of defaultThreadPool). Throw BadBoxParameters if the
+// box is not valid
+void buildCartesianMesh (tCompactMeshData &mesh, const tBoxParameters &box);
+void buildCylindricalMesh (tCompactMeshData &mesh, const tBoxParameters &box);
+
+#endif
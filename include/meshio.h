@@ -0,0 +1,193 @@
+#ifndef MESHIO_H_
+#define MESHIO_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include "definitions.h"
+#include "mesh.h"
+#include "transient_sink.h"
+
+// Binary container for meshes and results: a header, named arrays of fixed
+// width little-endian values, each one aligned to 64 bytes, and a table with
+// the name, type, shape and position of every array at the end, so arrays can
+// be written one after the other without knowing their number beforehand.
+//
+//   header  "HEFESTO\0", uint32 version, uint32 0, uint64 position of the
+//           table, uint64 number of arrays (64 bytes in total)
+//   table   for each array: char name[48] (ending in \0), uint32 type,
+//           uint32 width, uint64 rows, uint64 position of the values
+//
+// Arrays have rows x width values. The versions that can be read are the ones
+// up to BINARY_FILE_VERSION (version 2 added the uint8 and int64 types)
+
+#define BINARY_FILE_VERSION 2
+
+enum BinaryType {binary_int32 = 1, binary_float32 = 2, binary_float64 = 3,
+                 binary_uint8 = 4, binary_int64 = 5};
+
+typedef struct _tBinaryArray
+{
+    std::string name;
+    BinaryType type;
+    int width;
+    uint64_t rows;
+    uint64_t offset;
+} tBinaryArray;
+
+
+// Writes a binary file array by array. Throws BinaryFileError if the file can
+// not be written
+class BinaryWriter
+{
+public:
+
+    BinaryWriter (const std::string &path);
+
+    // Appends an array of rows x width values, written as they are (the name
+    // must be unique and shorter than 48 characters)
+    void addArray (const std::string &name, const int32_t *values,
+                   uint64_t rows, int width);
+    void addArray (const std::string &name, const float *values,
+                   uint64_t rows, int width);
+    void addArray (const std::string &name, const double *values,
+                   uint64_t rows, int width);
+    void addArray (const std::string &name, const uint8_t *values,
+                   uint64_t rows, int width);
+    void addArray (const std::string &name, const int64_t *values,
+                   uint64_t rows, int width);
+
+    // Same but the rows are given in parts, by successive calls to
+    // appendRows, so they do not need to be all in memory at once. Only one
+    // array can be open at a time
+    void beginArray (const std::string &name, BinaryType type, int width);
+    void appendRows (const void *values, uint64_t rows);
+    void endArray ();
+
+    // writes the table, also done by the destructor
+    void close ();
+
+    ~BinaryWriter ();
+
+private:
+
+    void write (const void *values, uint64_t count, int size);
+    void align ();
+
+    FILE *file_;
+    uint64_t position_;
+    std::vector<tBinaryArray> arrays_;
+    bool open_array_;
+};
+
+
+// Binary file mapped in memory (read only). The arrays are used in place, so
+// their values are only read from the disk when they are accessed. Throws
+// BinaryFileError if the file can not be read and BadBinaryFile if it is not
+// a valid binary file
+class BinaryFile
+{
+public:
+
+    BinaryFile (const std::string &path);
+
+    const std::vector<tBinaryArray>& getArrays () const;
+
+    // nullptr if there is no array with that name
+    const tBinaryArray* findArray (const std::string &name) const;
+
+    // Values of the array with that name, which must have the given type (and
+    // width if it is not 0). Throws BadBinaryFile otherwise
+    const int32_t* int32Array (const std::string &name, uint64_t &rows,
+                               int width = 0) const;
+    const float* float32Array (const std::string &name, uint64_t &rows,
+                               int width = 0) const;
+    const double* float64Array (const std::string &name, uint64_t &rows,
+                                int width = 0) const;
+    const uint8_t* uint8Array (const std::string &name, uint64_t &rows,
+                               int width = 0) const;
+    const int64_t* int64Array (const std::string &name, uint64_t &rows,
+                               int width = 0) const;
+
+    ~BinaryFile ();
+
+private:
+
+    BinaryFile (const BinaryFile &other);
+    BinaryFile& operator= (const BinaryFile &other);
+
+    const void* array (const std::string &name, BinaryType type,
+                       uint64_t &rows, int width) const;
+
+    char *data_;
+    uint64_t size_;
+    std::vector<tBinaryArray> arrays_;
+};
+
+
+// A mesh is stored in the arrays mesh.dimensions (problem_dimensions, n_volms
+// and n_boundaries), mesh.position, mesh.surface, mesh.connectivity,
+// mesh.volumes and mesh.boundaries, with the data of tCompactMeshData
+void writeMesh (BinaryWriter &writer, const tCompactMeshData &mesh);
+
+// same for a tMeshData, rho and cp are 0 for volumes that do not have them
+void writeMesh (BinaryWriter &writer, const tMeshData &mesh);
+
+// Arrays of the mesh in file, without copying them. A Mesh can be built
+// directly from the view while file lives
+tMeshView readMesh (const BinaryFile &file);
+
+// Temperatures (or any other value per volume) of a steady solution, and of
+// the rows of a transitory (as stored by Mesh::solveTransitory) with the time
+// of each one in name.time
+void writeField (BinaryWriter &writer, const std::string &name,
+                 const DoubleVector &values);
+
+void writeTransient (BinaryWriter &writer, const std::string &name,
+                     const DoubleMatrix &values, const DoubleVector &times);
+
+
+// Writes the snapshots of a transitory to writer as they come, in the array
+// name (one row per snapshot) and their times in name.time, in the same format
+// as writeTransient. With single_precision = true the values are stored as
+// float32. With delta = true each snapshot is stored as the XOR of its bits
+// with the ones of the previous snapshot (of zero for the first one), dropping
+// the bytes that are zero at the top of each value. Values that change little
+// between snapshots share their sign, exponent and first digits, so most of
+// their bytes are dropped. The encoded snapshots go one after the other to
+// name.delta, the position where each one begins to name.offset and the bytes
+// per value (4 or 8) and n_nodes to name.encoding.
+// Any other array can be written before begin or after end
+class BinarySink : public TransientSink
+{
+public:
+
+    BinarySink (BinaryWriter &writer, const std::string &name = "T",
+                bool single_precision = false, bool delta = false);
+
+    void begin (int n_nodes, int n_snapshots) override;
+    void store (double time, const DoubleVector &T) override;
+    void end () override;
+
+private:
+
+    BinaryWriter &writer_;
+    std::string name_;
+    bool single_precision_;
+    bool delta_;
+
+    DoubleVector times_;
+    std::vector<int64_t> offsets_;
+
+    std::vector<float> single_;
+    std::vector<uint64_t> previous_; // bits of the previous snapshot
+    std::vector<uint8_t> encoded_;
+};
+
+
+// Reads the snapshots and their times written by writeTransient or by a
+// BinarySink in any of its formats
+void readTransient (const BinaryFile &file, const std::string &name,
+                    DoubleMatrix &values, DoubleVector &times);
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef MULTIGRID_H_
+#define MULTIGRID_H_
+
+#include "definitions.h"
+#include "sparse.h"
+#include "preconditioner.h"
+
+enum CycleType {v_cycle, f_cycle};
+
+
+// Interpolation from the nodes of a coarse level to the ones of the next finer
+// level, in CSR format (one row per fine node, one column per coarse node)
+typedef struct _tProlongation
+{
+    int n_fine;
+    int n_coarse;
+
+    std::vector<int> row_start;
+    std::vector<int> col_index;
+    DoubleVector value;
+} tProlongation;
+
+
+// Builds the prolongations of a structured mesh numbered in order (the grid is
+// deduced from the index offsets of the system, see lineByLineTDMA). Each level
+// halves the number of nodes along every axis longer than two nodes and coarse
+// values are interpolated linearly between cell centers. Throws
+// NotStructuredSystem if the system does not come from such a mesh.
+// coarse_systems, if given, gets the Galerkin product of each level
+// (coarse_systems[l] is level l+1)
+void buildGeometricProlongations (const tSparseSystem &system,
+                                  std::vector<tProlongation> &prolongations,
+                                  std::vector<tSparseSystem> *coarse_systems = nullptr);
+
+// Computes the coarse system P^T * A * P (Galerkin product) with the diagonal
+// first in each row. The independent terms of coarse are left to zero
+void galerkinProduct (const tSparseSystem &fine, const tProlongation &P,
+                      tSparseSystem &coarse);
+
+
+// Builds the prolongations of any system by smoothed aggregation, using only
+// its coefficients. Nodes are grouped with their strongly connected neighbors
+// (|a_ij| >= 0.08*sqrt(a_ii*a_jj)), each aggregate becomes one coarse node and
+// the piecewise constant interpolation is smoothed with a damped Jacobi step.
+// Levels are added until the coarsest has few nodes or stops shrinking.
+// Each level is aggregated from the Galerkin product of the previous one, which
+// are kept in coarse_systems if given, as in buildGeometricProlongations
+void buildAggregationProlongations (const tSparseSystem &system,
+                                    std::vector<tProlongation> &prolongations,
+                                    std::vector<tSparseSystem> *coarse_systems = nullptr);
+
+
+// Levels of a multigrid solver, from the original system (level 0) to the
+// coarsest one, which is solved with a dense Cholesky factorization when it is
+// small enough and with Gauss-Seidel sweeps otherwise. Only the coarse levels
+// are stored, so the hierarchy can be kept in the cache of the system
+class MultigridHierarchy : public SolverSetup
+{
+public:
+
+    // prolongations[l] interpolates level l+1 into level l and coarse[l] is
+    // the system of level l+1, computed here if coarse does not have one per
+    // prolongation. Both are moved into the hierarchy (left empty)
+    MultigridHierarchy (const tSparseSystem &system,
+                        std::vector<tProlongation> &prolongations,
+                        std::vector<tSparseSystem> &coarse);
+
+    int getNumLevels () const;
+
+    // Applies one cycle to improve solution as a solution of A*x = rhs, where
+    // A is the matrix of system, the one given to the constructor. Levels are
+    // smoothed with n_smooth forward Gauss-Seidel sweeps before going to the
+    // coarser level and n_smooth backward sweeps after, so the cycle is
+    // symmetric
+    void cycle (const tSparseSystem &system, const DoubleVector &rhs,
+                DoubleVector &solution, CycleType type, int n_smooth = 2) const;
+
+private:
+
+    void cycle (const tSparseSystem &system, int level, CycleType type,
+                int n_smooth) const;
+    void solveCoarsest (const tSparseSystem &system) const;
+
+    std::vector<tSparseSystem> coarse_;         // levels 1 ... n_levels-1
+    std::vector<tProlongation> prolongations_;
+
+    // cholesky factor of the coarsest level, dense and by rows (empty if the
+    // level is too big)
+    DoubleVector coarsest_factor_;
+
+    // independent terms, solutions and residuals of each level
+    mutable std::vector<DoubleVector> rhs_;
+    mutable std::vector<DoubleVector> solution_;
+    mutable std::vector<DoubleVector> residual_;
+};
+
+
+// Hierarchies stored in the cache of a system, one for each way of building
+// the prolongations
+class GeometricMultigridSetup : public MultigridHierarchy
+{
+public:
+
+    GeometricMultigridSetup (const tSparseSystem &system,
+                             std::vector<tProlongation> &prolongations,
+                             std::vector<tSparseSystem> &coarse);
+};
+
+class AlgebraicMultigridSetup : public MultigridHierarchy
+{
+public:
+
+    AlgebraicMultigridSetup (const tSparseSystem &system,
+                             std::vector<tProlongation> &prolongations,
+                             std::vector<tSparseSystem> &coarse);
+};
+
+
+// One V cycle starting from zero as preconditioner (M^-1*r is the result)
+class MultigridPreconditioner : public Preconditioner
+{
+public:
+
+    // system and hierarchy must outlive the preconditioner
+    MultigridPreconditioner (const tSparseSystem &system,
+                             const MultigridHierarchy &hierarchy);
+
+    void apply (const DoubleVector &r, DoubleVector &z) const override;
+
+private:
+
+    const tSparseSystem &system_;
+    const MultigridHierarchy &hierarchy_;
+};
+
+#endif
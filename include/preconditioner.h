@@ -0,0 +1,85 @@
+#ifndef PRECONDITIONER_H_
+#define PRECONDITIONER_H_
+
+#include "definitions.h"
+#include "sparse.h"
+
+
+// abstract class for an approximation M of the matrix of a system whose
+// inverse is cheap to apply, used to speed up Krylov solvers
+class Preconditioner
+{
+public:
+
+    // computes z = M^-1 * r
+    virtual void apply (const DoubleVector &r, DoubleVector &z) const = 0;
+
+    // Same for n_rhs vectors stored interleaved, the value of node i of vector
+    // s being at i*n_rhs + s. By default each vector is applied on its own
+    virtual void applyBlock (const DoubleVector &r, DoubleVector &z,
+                             int n_rhs) const;
+
+    virtual ~Preconditioner () {}
+};
+
+
+
+// M = D, the diagonal of the system
+class JacobiPreconditioner : public Preconditioner
+{
+public:
+
+    JacobiPreconditioner (const tSparseSystem &system);
+
+    void apply (const DoubleVector &r, DoubleVector &z) const override;
+    void applyBlock (const DoubleVector &r, DoubleVector &z,
+                     int n_rhs) const override;
+
+private:
+
+    DoubleVector inv_diagonal_;
+};
+
+
+
+// M = (D/w + L) * (D/w)^-1 * (D/w + U) * w/(2-w), that is, a forward and a
+// backward SOR sweep with relaxation factor w (0 < w < 2)
+class SSORPreconditioner : public Preconditioner
+{
+public:
+
+    // system must outlive the preconditioner
+    SSORPreconditioner (const tSparseSystem &system, double omega = 1);
+
+    void apply (const DoubleVector &r, DoubleVector &z) const override;
+
+private:
+
+    const tSparseSystem &system_;
+    double omega_;
+};
+
+
+
+// M = L * L^T, where L is the incomplete Cholesky factor of the system with
+// no fill in (IC(0)), that is, with the same sparsity as the lower half of the
+// system. Throws NotPositiveDefinite if the factorization breaks down
+class ICPreconditioner : public Preconditioner
+{
+public:
+
+    ICPreconditioner (const tSparseSystem &system);
+
+    void apply (const DoubleVector &r, DoubleVector &z) const override;
+    void applyBlock (const DoubleVector &r, DoubleVector &z,
+                     int n_rhs) const override;
+
+private:
+
+    // rows of L in CSR format, columns sorted and the diagonal the last one
+    std::vector<int> row_start_;
+    std::vector<int> col_index_;
+    DoubleVector value_;
+};
+
+#endif
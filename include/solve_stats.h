@@ -0,0 +1,113 @@
+#ifndef SOLVE_STATS_H_
+#define SOLVE_STATS_H_
+
+#include <functional>
+#include "definitions.h"
+#include "sparse.h"
+
+
+// What a solve did, filled by the solvers of solver.h while a SolveStatsScope
+// for it is alive in the thread that calls them (Mesh::solveMesh opens one
+// when it is given stats). Times and work are added up, so the same stats can
+// gather several solves
+typedef struct _tSolveStats
+{
+    // the value each iteration compared with the tolerance, as printed by
+    // verbose. Direct solvers do no iterations
+    int iterations;
+    DoubleVector residuals;
+
+    // wall time in s of assembling the system (Mesh::solveMesh), of building
+    // the setups of the solver (factorizations, hierarchies, colorings...)
+    // and of the iterations or triangular solves
+    double assembly_time;
+    double setup_time;
+    double solve_time;
+
+    // Estimates of the floating point operations and the bytes read from or
+    // written to memory by the iterations, without the setups. Each
+    // coefficient counts as 12 bytes (value and column) and each entry of a
+    // vector as 8, as if nothing stayed in cache
+    double flops;
+    double bytes;
+
+    // if set, called after every iteration with its number and residual, so
+    // that slow solves can be watched while they run
+    std::function<void(int, double)> monitor;
+} tSolveStats;
+
+
+// Sets everything but monitor to zero
+void resetSolveStats (tSolveStats &stats);
+
+// seconds of a steady clock, to time the phases
+double statsClock ();
+
+
+// Makes the solvers called from this thread record their work in stats until
+// it is destroyed, and times them from its construction. With stats = nullptr
+// nothing is recorded. Scopes can be nested, the inner one wins while it lives
+class SolveStatsScope
+{
+public:
+
+    SolveStatsScope (tSolveStats *stats);
+    ~SolveStatsScope ();
+
+private:
+
+    SolveStatsScope (const SolveStatsScope &other);
+
+    tSolveStats *previous_;
+    double previous_start_;
+    double previous_setup_end_;
+};
+
+
+// For the solvers. The stats of the current scope of this thread, nullptr if
+// there is none, and the time its solver started and finished its setups
+// (negative until it does)
+extern thread_local tSolveStats *active_solve_stats;
+extern thread_local double solve_stats_start;
+extern thread_local double solve_stats_setup_end;
+
+// The solver finished building its setups and starts iterating. Every solver
+// must say it, even without setups, since the work before it is not counted
+void statsSetupDone ();
+
+// adds work done by the solver
+inline void statsWork (double flops, double bytes)
+{
+    if (active_solve_stats and solve_stats_setup_end >= 0)
+    {
+        active_solve_stats->flops += flops;
+        active_solve_stats->bytes += bytes;
+    }
+}
+
+// the solver finished an iteration with that residual
+inline void statsIteration (double residual)
+{
+    tSolveStats *stats = active_solve_stats;
+
+    if (stats)
+    {
+        stats->residuals.push_back(residual);
+        stats->iterations++;
+
+        if (stats->monitor)
+            stats->monitor(stats->iterations, residual);
+    }
+}
+
+// work of going once through the coefficients of system, as in multiply or
+// gaussSeidelSweep, plus extra_flops and extra_bytes for each row
+inline void statsSweep (const tSparseSystem &system, double extra_flops = 0,
+                        double extra_bytes = 0)
+{
+    if (active_solve_stats and solve_stats_setup_end >= 0)
+        statsWork(2.0*system.value.size() + extra_flops*system.n_rows,
+                  12.0*system.value.size() + (4 + extra_bytes)*system.n_rows);
+}
+
+#endif
@@ -2,11 +2,124 @@
 #define SOLVER_H_
 
 #include "definitions.h"
+#include "sparse.h"
+#include "preconditioner.h"
 
-void gaussSeidel (const DoubleMatrix &system, DoubleVector &solution,
+// Iterative solvers start from the values of solution when it has one per
+// equation (see initialGuess in sparse.h), so a previous solution of a similar
+// system saves most of the iterations, and from zero otherwise
+
+void gaussSeidel (const tSparseSystem &system, DoubleVector &solution,
                  double tolerance, bool verbose);
 
-void TDMA (const DoubleMatrix &system, DoubleVector &solution,
+// Gauss-Seidel where nodes are updated by colors (red-black for structured
+// meshes), nodes that share a coefficient never having the same color (also
+// when only one of a_ij and a_ji is stored). All the nodes of a color are
+// updated in parallel in the threads of defaultThreadPool. The coloring is
+// kept in the cache of the system
+void multicolorGaussSeidel (const tSparseSystem &system, DoubleVector &solution,
+                            double tolerance, bool verbose);
+
+// Successive over-relaxation (SOR) and its symmetric version (SSOR, a forward
+// and a backward sweep per iteration) with relaxation factor omega, which must
+// be 0 < w < 2 (BadRelaxationFactor otherwise). Without omega, it is estimated
+// from the convergence rate observed in the first sweeps (SSOR keeps it in the
+// cache of the system), and these versions can be given to Mesh::solveMesh
+void SOR (const tSparseSystem &system, DoubleVector &solution,
+          double tolerance, bool verbose, double omega);
+
+void SOR (const tSparseSystem &system, DoubleVector &solution,
+          double tolerance, bool verbose);
+
+void SSOR (const tSparseSystem &system, DoubleVector &solution,
+           double tolerance, bool verbose, double omega);
+
+void SSOR (const tSparseSystem &system, DoubleVector &solution,
+           double tolerance, bool verbose);
+
+// One Gauss-Seidel pass over all the equations of system taking rhs as the
+// independent terms, in reverse order if backward = true. Returns the biggest
+// change of the solution
+double gaussSeidelSweep (const tSparseSystem &system, const DoubleVector &rhs,
+                         DoubleVector &solution, bool backward = false);
+
+// Same as gaussSeidelSweep but relaxing each update by omega
+double relaxationSweep (const tSparseSystem &system, const DoubleVector &rhs,
+                        DoubleVector &solution, double omega,
+                        bool backward = false);
+
+// Gauss-Seidel iterations over whole lines of nodes instead of single nodes.
+// Meant for structured meshes numbered in order (throws NotStructuredSystem if
+// coefficients link nodes along more than three index offsets). Each iteration
+// goes through the lines of every direction solving each one with TDMA, and
+// lines that are not coupled between them are solved in parallel. The lines
+// and their factorizations are kept in the cache of the system
+void lineByLineTDMA (const tSparseSystem &system, DoubleVector &solution,
+                     double tolerance, bool verbose);
+
+// Preconditioned conjugate gradient for the symmetric positive definite
+// systems assembled by Mesh. It stops once no equation would change its node
+// more than tolerance in a Jacobi iteration (max |r_i/a_ii| <= tolerance)
+void conjugateGradient (const tSparseSystem &system, DoubleVector &solution,
+                        double tolerance, bool verbose,
+                        const Preconditioner &preconditioner);
+
+// conjugateGradient with each one of the preconditioners of preconditioner.h,
+// so that they can be given to Mesh::solveMesh. The incomplete Cholesky
+// factorization is kept in the cache of the system
+void conjugateGradientJacobi (const tSparseSystem &system, DoubleVector &solution,
+                              double tolerance, bool verbose);
+
+void conjugateGradientSSOR (const tSparseSystem &system, DoubleVector &solution,
+                            double tolerance, bool verbose);
+
+void conjugateGradientIC (const tSparseSystem &system, DoubleVector &solution,
+                          double tolerance, bool verbose);
+
+// conjugateGradient for n_rhs systems that only differ in their independent
+// terms, all of them with the matrix of system (its rhs is not used). The
+// independent terms and solutions are stored interleaved, the value of node i
+// for system s being at i*n_rhs + s, so each coefficient of the matrix and of
+// the preconditioner is read once for all the systems. solution is used as
+// initial guess if it has n_rows*n_rhs values. Each system stops when it meets
+// tolerance
+void blockConjugateGradient (const tSparseSystem &system, const DoubleVector &rhs,
+                             DoubleVector &solution, int n_rhs, double tolerance,
+                             bool verbose, const Preconditioner &preconditioner);
+
+// Geometric multigrid for structured meshes numbered in order (see
+// buildGeometricProlongations in multigrid.h), repeating V or F cycles with
+// Gauss-Seidel smoothing until the residual is small as in conjugateGradient
+void multigridV (const tSparseSystem &system, DoubleVector &solution,
+                 double tolerance, bool verbose);
+
+void multigridF (const tSparseSystem &system, DoubleVector &solution,
+                 double tolerance, bool verbose);
+
+// Algebraic multigrid (smoothed aggregation, see buildAggregationProlongations
+// in multigrid.h) for any mesh, either repeating V cycles or as preconditioner
+// of conjugateGradient. Multigrid hierarchies are kept in the cache of the
+// system and reused while its coefficients do not change
+void algebraicMultigrid (const tSparseSystem &system, DoubleVector &solution,
+                         double tolerance, bool verbose);
+
+void conjugateGradientAMG (const tSparseSystem &system, DoubleVector &solution,
+                           double tolerance, bool verbose);
+
+// Direct solver for systems where every equation only involves nodes i-1, i
+// and i+1, like the ones of 1D meshes numbered in order (throws
+// NotTridiagonalSystem otherwise). It needs no tolerance and the factorization
+// is kept in the cache of the system
+void TDMA (const tSparseSystem &system, DoubleVector &solution,
            double void_parameter, bool verbose);
 
-#endif
\ No newline at end of file
+// Direct solver for the symmetric positive definite systems assembled by Mesh
+// (sparse Cholesky factorization with a minimum degree ordering, see
+// cholesky.h). It needs no tolerance. The ordering and the positions of the
+// coefficients of the factor are kept in the cache of the system while the
+// positions of its coefficients do not change, and the factor itself while
+// their values do not, so later solves only do two triangular solves
+void sparseCholesky (const tSparseSystem &system, DoubleVector &solution,
+                     double void_parameter, bool verbose);
+
+#endif
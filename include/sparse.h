@@ -0,0 +1,146 @@
+#ifndef SPARSE_H_
+#define SPARSE_H_
+
+#include <memory>
+#include "definitions.h"
+
+
+// base class for the data a solver builds from the coefficients of a system
+// (factorizations, multigrid hierarchies...) and keeps for later solves
+class SolverSetup
+{
+public:
+
+    // true for setups that only depend on which coefficients the system has
+    // and not on their values (orderings, colorings...), which are kept when
+    // only the values change (see clearSetups)
+    virtual bool structural () const { return false; }
+
+    virtual ~SolverSetup () {}
+};
+
+
+// Setups stored along with a system. They belong to the coefficients of that
+// system, so copying or assigning a system never carries them along
+class SolverSetupCache
+{
+public:
+
+    SolverSetupCache () {}
+    SolverSetupCache (const SolverSetupCache &other) {}
+
+    SolverSetupCache& operator= (const SolverSetupCache &other)
+    {
+        setups.clear();
+        return *this;
+    }
+
+    std::vector<std::shared_ptr<SolverSetup>> setups;
+};
+
+
+// Linear system of equations stored in compressed sparse row (CSR) format.
+// The coefficients of row i are value[row_start[i]] ... value[row_start[i+1]-1]
+// and col_index holds the column of each one of them. The independent terms
+// are kept apart in rhs, so that the ith equation reads sum(a_ij * x_j) = rhs_i.
+// The first coefficient of each row must be the diagonal one (a_ii) and the
+// rest are the ones of its neighbors, which lets solvers visit only them
+typedef struct _tSparseSystem
+{
+    int n_rows;
+
+    std::vector<int> row_start; // size n_rows+1
+    std::vector<int> col_index; // size nnz
+    DoubleVector value;         // size nnz
+
+    DoubleVector rhs;           // size n_rows
+
+    // setups built by the solvers for these coefficients, they do not depend
+    // on rhs. clearSetups must be called whenever the coefficients change
+    mutable SolverSetupCache cache;
+} tSparseSystem;
+
+
+// Empties the system and prepares it for n_rows rows. nnz_estimate is only used
+// to reserve memory, rows are appended later with addCoefficient and closeRow.
+// The first coefficient added to each row must be its diagonal
+void initSparseSystem (tSparseSystem &system, int n_rows, int nnz_estimate);
+
+// Returns the setup of type T stored in system, or nullptr if there is none
+template <class T>
+T* findSetup (const tSparseSystem &system)
+{
+    for (int i = 0; i < system.cache.setups.size(); i++)
+    {
+        T *setup = dynamic_cast<T*>(system.cache.setups[i].get());
+
+        if (setup != nullptr)
+            return setup;
+    }
+
+    return nullptr;
+}
+
+// Same as findSetup but sharing the ownership of the setup, for the ones that
+// other setups keep (they may outlive it in the cache, see clearSetups)
+template <class T>
+std::shared_ptr<T> findSharedSetup (const tSparseSystem &system)
+{
+    for (int i = 0; i < system.cache.setups.size(); i++)
+    {
+        std::shared_ptr<T> setup =
+            std::dynamic_pointer_cast<T>(system.cache.setups[i]);
+
+        if (setup)
+            return setup;
+    }
+
+    return nullptr;
+}
+
+// Stores setup in system and returns it
+template <class T>
+T* addSetup (const tSparseSystem &system, T *setup)
+{
+    system.cache.setups.push_back(std::shared_ptr<SolverSetup>(setup));
+    return setup;
+}
+
+// Same as addSetup for a setup whose ownership is shared
+template <class T>
+std::shared_ptr<T> addSetup (const tSparseSystem &system,
+                             const std::shared_ptr<T> &setup)
+{
+    system.cache.setups.push_back(setup);
+    return setup;
+}
+
+// Prepares solution as the starting point of an iterative solver: the values
+// it has are kept as initial guess if there is one per row of system,
+// otherwise it starts from zero
+void initialGuess (const tSparseSystem &system, DoubleVector &solution);
+
+// Discards all the setups of system, or only the ones that are not structural
+// if keep_structural = true, for when the values of the coefficients change
+// but not their positions
+void clearSetups (const tSparseSystem &system, bool keep_structural = false);
+
+// Adds value to the coefficient of the given column in the row that is being
+// assembled (the first one that has not been closed yet). If the coefficient
+// is not present yet it is appended to the row
+void addCoefficient (tSparseSystem &system, int column, double value);
+
+// Finishes the assembly of the current row, the next calls to addCoefficient
+// will affect the following row
+void closeRow (tSparseSystem &system);
+
+// Computes result = A*x, where A is the matrix of coefficients of the system
+void multiply (const tSparseSystem &system, const DoubleVector &x,
+               DoubleVector &result);
+
+// Largest correction |r_i/a_ii| that a Jacobi iteration would apply to the
+// solution whose residual is r. Iterative solvers stop when it falls below
+// their tolerance, so that it means the same as in gaussSeidel
+double scaledResidual (const tSparseSystem &system, const DoubleVector &r);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include <functional>
+#include <string>
+#include "meshgen.h"
+
+
+typedef struct _tSweepResult
+{
+    int index; // position of the case in the sweep
+    tFinParameters fin;
+
+    // temperatures of the volumes, heat given by the tube to the fin (W) and
+    // efficiency of the fin (heat over the one of a fin at Ta everywhere)
+    DoubleVector T;
+    double heat;
+    double efficiency;
+
+    // what() of the exception thrown by the case, empty if it was solved
+    std::string error;
+} tSweepResult;
+
+
+// Solves the fin of every case with solver (as in Mesh::solveMesh) in the
+// threads of defaultThreadPool (see ThreadPool::parallelTasks) and calls
+// on_result with each one as soon as it is solved, in the order they finish
+// and never from two threads at once. Each thread keeps its Mesh: when a case
+// has the same geometry (Ra, Rb, e and n_elms) as the previous one of the
+// thread only its data is updated (see Mesh::setNodeData), so listing the
+// cases that share geometry together saves most of the assembly and the
+// setups of the solver, and otherwise the solve starts from the previous
+// temperatures if the number of volumes is the same
+void runFinSweep (const std::vector<tFinParameters> &cases,
+                  void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                  double tolerance,
+                  const std::function<void(const tSweepResult&)> &on_result);
+
+#endif
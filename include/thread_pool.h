@@ -0,0 +1,86 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads used to run loops whose iterations are
+// independent. The thread that calls parallelFor also takes part in the work.
+// A loop started while the pool is already running another one (from inside
+// its body or from another thread) runs entirely in the calling thread
+class ThreadPool
+{
+public:
+
+    // n_threads counts the calling thread, so n_threads = 1 runs everything
+    // sequentially without launching any worker
+    ThreadPool (int n_threads);
+
+    int getNumThreads () const;
+
+    // Calls body(begin, end) for consecutive chunks of [0, n) of at most
+    // chunk_size iterations until the range is covered, and returns once all
+    // of them have finished. Chunks are handed out dynamically, so body must
+    // not depend on which thread runs it
+    void parallelFor (int n, int chunk_size,
+                      const std::function<void(int,int)> &body);
+
+    // Calls body(thread, i) for every i in [0, n), for loops whose iterations
+    // are long and of uneven cost. Each thread starts with a block of
+    // consecutive iterations and, once it runs out, steals the second half of
+    // the iterations left to the thread with most of them, so consecutive
+    // iterations tend to run in the same thread. thread is in
+    // [0, getNumThreads()) and iterations with the same thread never run at
+    // the same time, so it can be used to index per-thread workspaces
+    void parallelTasks (int n, const std::function<void(int,int)> &body);
+
+    ~ThreadPool ();
+
+private:
+
+    // iterations [begin, end) not started yet of a thread in parallelTasks
+    typedef struct _tTaskRange
+    {
+        std::mutex mutex;
+        int begin;
+        int end;
+    } tTaskRange;
+
+    // runs the loop in the workers, or in the calling thread if the pool is
+    // busy. task = true for parallelTasks
+    void run (int n, int chunk_size,
+              const std::function<void(int,int)> &body, bool task);
+
+    void workerLoop (int thread);
+    void runChunks (int thread);
+    void runTasks (int thread);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable job_ready_;
+    std::condition_variable job_done_;
+    unsigned long job_id_;
+    int busy_workers_;
+    bool stop_;
+    std::atomic<bool> running_;
+
+    // description of the loop that is being run
+    const std::function<void(int,int)> *body_;
+    bool task_;
+    int n_;
+    int chunk_size_;
+    std::atomic<int> next_chunk_;
+    std::vector<tTaskRange> task_ranges_; // one per thread
+};
+
+
+// Pool shared by the solvers, with one thread per hardware core
+ThreadPool& defaultThreadPool ();
+
+#endif
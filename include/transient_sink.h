@@ -0,0 +1,101 @@
+#ifndef TRANSIENT_SINK_H_
+#define TRANSIENT_SINK_H_
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "definitions.h"
+
+
+// Receives the temperatures of a transitory as they are stored (see
+// Mesh::solveTransitory), so they do not need to be all in memory at once
+class TransientSink
+{
+public:
+
+    // before the first snapshot, with the number of values of each one and
+    // the number of snapshots that will be stored
+    virtual void begin (int n_nodes, int n_snapshots) {}
+
+    // temperatures of all the volumes at time, only valid during the call
+    virtual void store (double time, const DoubleVector &T) = 0;
+
+    // after the last snapshot
+    virtual void end () {}
+
+    // waits until the snapshots stored so far are delivered, called before
+    // each checkpoint of the transitory (see Mesh::setCheckpoints) so that it
+    // never counts snapshots that could still be lost
+    virtual void flush () {}
+
+    virtual ~TransientSink () {}
+};
+
+
+// Keeps the snapshots in the rows of T, which is only resized if its size is
+// not the right one. times, if given, gets the time of each row
+class MatrixSink : public TransientSink
+{
+public:
+
+    MatrixSink (DoubleMatrix &T, DoubleVector *times = nullptr);
+
+    void begin (int n_nodes, int n_snapshots) override;
+    void store (double time, const DoubleVector &T) override;
+
+private:
+
+    DoubleMatrix &T_;
+    DoubleVector *times_;
+    int next_;
+};
+
+
+// Passes the snapshots to another sink from a thread of its own, so writing
+// them overlaps with the next time steps. Up to max_pending snapshots wait in
+// memory, and store blocks while they are all taken. An exception thrown by
+// the other sink is thrown again by the next call to store or end, and store
+// throws SinkNotStarted before begin and after end or an error
+class AsyncSink : public TransientSink
+{
+public:
+
+    AsyncSink (TransientSink &sink, int max_pending = 4);
+
+    void begin (int n_nodes, int n_snapshots) override;
+    void store (double time, const DoubleVector &T) override;
+    void end () override;
+
+    // waits for the snapshots that are pending to be given to the other sink,
+    // and throws its error if there was one
+    void flush () override;
+
+    // waits for the snapshots that are pending, but errors are only reported
+    // by end
+    ~AsyncSink ();
+
+private:
+
+    void writerLoop ();
+    void stop ();
+    void rethrow ();
+
+    TransientSink &sink_;
+    int max_pending_;
+    std::thread writer_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool finished_;
+    std::exception_ptr error_;
+
+    // snapshots waiting to be written, in order, and buffers already used
+    // that can be filled again
+    std::vector<double> pending_times_;
+    std::vector<DoubleVector> pending_;
+    std::vector<DoubleVector> free_;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "checkpoint.h"
+#include <limits.h>
+#include <stdio.h>
+#include "exceptions.h"
+#include "meshio.h"
+
+
+void writeCheckpoint (const std::string &path, const tTransientState &state)
+{
+    std::string partial = path + ".partial";
+
+    {
+        BinaryWriter writer(partial);
+
+        int64_t integers[10] = {state.adaptive, state.scheme, state.step,
+                                state.time_steps, state.store_each,
+                                state.n_outputs, state.next_output,
+                                state.n_steps, state.n_rejected,
+                                int64_t(state.fingerprint)};
+        double reals[5] = {state.t, state.tolerance, state.time, state.h,
+                           state.time_tolerance};
+
+        writer.addArray("checkpoint.integers", integers, 1, 10);
+        writer.addArray("checkpoint.reals", reals, 1, 5);
+        writer.addArray("checkpoint.T", state.T.data(), state.T.size(), 1);
+        writer.close();
+    }
+
+    if (rename(partial.c_str(), path.c_str()) != 0)
+        throw BinaryFileError();
+}
+
+
+void readCheckpoint (const std::string &path, tTransientState &state)
+{
+    BinaryFile file(path);
+    uint64_t rows;
+
+    const int64_t *integers = file.int64Array("checkpoint.integers", rows, 10);
+
+    if (rows != 1)
+        throw BadBinaryFile();
+
+    const double *reals = file.float64Array("checkpoint.reals", rows, 5);
+
+    if (rows != 1)
+        throw BadBinaryFile();
+
+    const double *T = file.float64Array("checkpoint.T", rows, 1);
+
+    // the values the transitory divides by or that select its path, so that a
+    // file that is not a checkpoint can not reach it
+    bool valid = (integers[1] >= implicit_euler and integers[1] <= explicit_rk2 and
+                  reals[0] > 0);
+
+    if (integers[0] != 0)
+        valid = valid and integers[5] > 0 and integers[5] <= INT_MAX and
+                integers[6] >= 0 and integers[6] <= integers[5] and
+                reals[4] > 0;
+    else
+        valid = valid and integers[3] > 0 and integers[3] <= INT_MAX and
+                integers[4] > 0 and integers[4] <= INT_MAX and
+                integers[2] >= 0 and integers[2] <= integers[3];
+
+    if (not valid)
+        throw BadBinaryFile();
+
+    state.adaptive = (integers[0] != 0);
+    state.scheme = TimeScheme(integers[1]);
+    state.step = integers[2];
+    state.time_steps = integers[3];
+    state.store_each = integers[4];
+    state.n_outputs = integers[5];
+    state.next_output = integers[6];
+    state.n_steps = integers[7];
+    state.n_rejected = integers[8];
+    state.fingerprint = integers[9];
+
+    state.t = reals[0];
+    state.tolerance = reals[1];
+    state.time = reals[2];
+    state.h = reals[3];
+    state.time_tolerance = reals[4];
+
+    state.T.assign(T, T + rows);
+}
+
+
+CheckpointWriter::CheckpointWriter (const std::string &path) :
+        path_(path), has_pending_(false), writing_(false), finished_(false)
+{
+    writer_ = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+
+void CheckpointWriter::save (const tTransientState &state)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (error_)
+    {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+
+    // the vector of the one waiting keeps its memory
+    DoubleVector T;
+    T.swap(pending_.T);
+    pending_ = state;
+    T.assign(state.T.begin(), state.T.end());
+    pending_.T.swap(T);
+
+    has_pending_ = true;
+    changed_.notify_all();
+}
+
+
+void CheckpointWriter::writerLoop ()
+{
+    tTransientState state;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true)
+    {
+        changed_.wait(lock, [this] { return has_pending_ or finished_; });
+
+        if (not has_pending_)
+            return;
+
+        std::swap(state, pending_);
+        has_pending_ = false;
+        writing_ = true;
+
+        lock.unlock();
+
+        std::exception_ptr error;
+
+        try
+        {
+            writeCheckpoint(path_, state);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+
+        writing_ = false;
+
+        if (error)
+            error_ = error;
+
+        changed_.notify_all();
+    }
+}
+
+
+void CheckpointWriter::finish ()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return not has_pending_ and not writing_; });
+
+    if (error_)
+    {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+
+CheckpointWriter::~CheckpointWriter ()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+
+    changed_.notify_all();
+    writer_.join();
+}
@@ -0,0 +1,425 @@
+#include "cholesky.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <math.h>
+#include <queue>
+#include "exceptions.h"
+#include "solve_stats.h"
+#include "solver.h"
+
+
+void minimumDegreeOrdering (const tSparseSystem &system, std::vector<int> &order)
+{
+    int n_nodes = system.n_rows;
+
+    // The graph left by the eliminations is kept as a quotient graph: each
+    // eliminated node becomes an element, the clique of the nodes it was
+    // connected to. A node that is not eliminated yet is linked to its
+    // neighbors that are not eliminated either (variables) and to the
+    // elements it belongs to. The pattern is made symmetric in case only one
+    // of a_ij and a_ji is stored
+    std::vector<std::vector<int>> variables(n_nodes);
+    std::vector<std::vector<int>> elements(n_nodes);
+    std::vector<std::vector<int>> clique(n_nodes); // of each element
+
+    for (int i = 0; i < n_nodes; i++)
+    {
+        for (int k = system.row_start[i]; k < system.row_start[i+1]; k++)
+        {
+            int j = system.col_index[k];
+
+            if (j != i)
+            {
+                variables[i].push_back(j);
+                variables[j].push_back(i);
+            }
+        }
+    }
+
+    // candidates by (degree, node), with entries left behind when the degree
+    // of a node changes, which are skipped when they come out
+    typedef std::pair<int, int> tCandidate;
+    std::priority_queue<tCandidate, std::vector<tCandidate>,
+                        std::greater<tCandidate>> candidates;
+
+    std::vector<int> degree(n_nodes);
+
+    for (int i = 0; i < n_nodes; i++)
+    {
+        std::sort(variables[i].begin(), variables[i].end());
+        variables[i].erase(std::unique(variables[i].begin(), variables[i].end()),
+                           variables[i].end());
+        degree[i] = variables[i].size();
+        candidates.push(tCandidate(degree[i], i));
+    }
+
+    std::vector<char> eliminated(n_nodes, 0);
+    std::vector<char> absorbed(n_nodes, 0);
+    std::vector<int> mark(n_nodes, -1);   // step in which a node joined L_p
+    std::vector<int> seen(n_nodes, -1);   // step in which outside was set
+    std::vector<int> outside(n_nodes, 0); // |L_e \ L_p| of each element e
+
+    order.clear();
+    order.reserve(n_nodes);
+
+    while (not candidates.empty())
+    {
+        tCandidate candidate = candidates.top();
+        candidates.pop();
+
+        int p = candidate.second;
+
+        if (eliminated[p] or candidate.first != degree[p])
+            continue;
+
+        int step = order.size();
+        order.push_back(p);
+        eliminated[p] = 1;
+        mark[p] = step;
+
+        // L_p: the neighbors of p and the nodes of its elements, which are
+        // absorbed by the new element
+        std::vector<int> &L_p = clique[p];
+
+        for (int k = 0; k < variables[p].size(); k++)
+        {
+            int j = variables[p][k];
+
+            if (mark[j] != step)
+            {
+                mark[j] = step;
+                L_p.push_back(j);
+            }
+        }
+
+        for (int k = 0; k < elements[p].size(); k++)
+        {
+            int e = elements[p][k];
+
+            if (absorbed[e])
+                continue;
+
+            for (int c = 0; c < clique[e].size(); c++)
+            {
+                int j = clique[e][c];
+
+                if (mark[j] != step)
+                {
+                    mark[j] = step;
+                    L_p.push_back(j);
+                }
+            }
+
+            absorbed[e] = 1;
+            std::vector<int>().swap(clique[e]);
+        }
+
+        std::vector<int>().swap(variables[p]);
+        std::vector<int>().swap(elements[p]);
+
+        // nodes of the other elements of the nodes of L_p that are not in it
+        for (int k = 0; k < L_p.size(); k++)
+        {
+            const std::vector<int> &adjacent = elements[L_p[k]];
+
+            for (int c = 0; c < adjacent.size(); c++)
+            {
+                int e = adjacent[c];
+
+                if (absorbed[e])
+                    continue;
+
+                if (seen[e] != step)
+                {
+                    seen[e] = step;
+                    outside[e] = clique[e].size();
+                }
+
+                outside[e]--;
+            }
+        }
+
+        // The nodes of L_p lose their links to the absorbed elements and to the
+        // nodes of L_p, now in element p. Their degree is approximated from
+        // above with the sizes of the elements and links that remain
+        int n_left = n_nodes - step - 1;
+
+        for (int k = 0; k < L_p.size(); k++)
+        {
+            int i = L_p[k];
+            int external = 0;
+
+            std::vector<int> &adjacent = elements[i];
+            int kept = 0;
+
+            for (int c = 0; c < adjacent.size(); c++)
+            {
+                int e = adjacent[c];
+
+                if (not absorbed[e])
+                {
+                    adjacent[kept++] = e;
+                    external += outside[e];
+                }
+            }
+
+            adjacent.resize(kept);
+            adjacent.push_back(p);
+
+            std::vector<int> &neighbors = variables[i];
+            kept = 0;
+
+            for (int c = 0; c < neighbors.size(); c++)
+                if (mark[neighbors[c]] != step)
+                    neighbors[kept++] = neighbors[c];
+
+            neighbors.resize(kept);
+
+            int in_p = L_p.size() - 1;
+            int bound = std::min(degree[i] + in_p, kept + in_p + external);
+
+            degree[i] = std::min(n_left, bound);
+            candidates.push(tCandidate(degree[i], i));
+        }
+    }
+}
+
+
+CholeskySymbolic::CholeskySymbolic (const tSparseSystem &system)
+{
+    int n_nodes = system.n_rows;
+
+    minimumDegreeOrdering(system, perm);
+
+    inv_perm.resize(n_nodes);
+
+    for (int k = 0; k < n_nodes; k++)
+        inv_perm[perm[k]] = k;
+
+    // elimination tree, following each coefficient of the upper part of
+    // P*A*P^T up to its root and compressing the paths on the way
+    parent.assign(n_nodes, -1);
+    std::vector<int> ancestor(n_nodes, -1);
+
+    for (int k = 0; k < n_nodes; k++)
+    {
+        int node = perm[k];
+
+        for (int p = system.row_start[node]; p < system.row_start[node+1]; p++)
+        {
+            int i = inv_perm[system.col_index[p]];
+
+            while (i != -1 and i < k)
+            {
+                int next = ancestor[i];
+                ancestor[i] = k;
+
+                if (next == -1)
+                    parent[i] = k;
+
+                i = next;
+            }
+        }
+    }
+
+    // columns of L from the patterns of its rows
+    std::vector<int> pattern(n_nodes);
+    std::vector<int> mark(n_nodes, -1);
+    std::vector<int> count(n_nodes, 1);
+
+    for (int k = 0; k < n_nodes; k++)
+    {
+        int top = rowPattern(system, k, pattern, mark);
+
+        for (int p = top; p < n_nodes; p++)
+            count[pattern[p]]++;
+    }
+
+    col_start.assign(n_nodes+1, 0);
+
+    for (int j = 0; j < n_nodes; j++)
+        col_start[j+1] = col_start[j] + count[j];
+
+    row_index.resize(col_start[n_nodes]);
+    std::vector<int> next(col_start.begin(), col_start.end()-1);
+    mark.assign(n_nodes, -1);
+
+    for (int k = 0; k < n_nodes; k++)
+    {
+        row_index[next[k]++] = k;
+
+        int top = rowPattern(system, k, pattern, mark);
+
+        for (int p = top; p < n_nodes; p++)
+            row_index[next[pattern[p]]++] = k;
+    }
+}
+
+
+int CholeskySymbolic::getNonZeros () const
+{
+    return row_index.size();
+}
+
+
+int CholeskySymbolic::rowPattern (const tSparseSystem &system, int k,
+                                  std::vector<int> &pattern,
+                                  std::vector<int> &mark) const
+{
+    int n_nodes = system.n_rows;
+    int top = n_nodes;
+    int node = perm[k];
+
+    mark[k] = k;
+
+    // each coefficient a_ik above the diagonal adds the path from i to k in
+    // the elimination tree, stopping at the nodes already visited
+    for (int p = system.row_start[node]; p < system.row_start[node+1]; p++)
+    {
+        int i = inv_perm[system.col_index[p]];
+
+        if (i > k)
+            continue;
+
+        int length = 0;
+
+        for (; mark[i] != k; i = parent[i])
+        {
+            pattern[length++] = i;
+            mark[i] = k;
+        }
+
+        while (length > 0)
+            pattern[--top] = pattern[--length];
+    }
+
+    return top;
+}
+
+
+CholeskyFactor::CholeskyFactor (const tSparseSystem &system,
+                                const std::shared_ptr<const CholeskySymbolic> &symbolic) :
+        symbolic_(symbolic)
+{
+    int n_nodes = system.n_rows;
+    const std::vector<int> &col_start = symbolic->col_start;
+    const std::vector<int> &row_index = symbolic->row_index;
+
+    value_.resize(row_index.size());
+
+    // up-looking factorization: row k of L from the rows before it
+    DoubleVector x(n_nodes, 0);
+    std::vector<int> pattern(n_nodes);
+    std::vector<int> mark(n_nodes, -1);
+    std::vector<int> next(n_nodes);
+
+    // next free position of each column, after its diagonal
+    for (int j = 0; j < n_nodes; j++)
+        next[j] = col_start[j] + 1;
+
+    for (int k = 0; k < n_nodes; k++)
+    {
+        int top = symbolic->rowPattern(system, k, pattern, mark);
+        int node = symbolic->perm[k];
+
+        for (int p = system.row_start[node]; p < system.row_start[node+1]; p++)
+        {
+            int i = symbolic->inv_perm[system.col_index[p]];
+
+            if (i <= k)
+                x[i] += system.value[p];
+        }
+
+        double d = x[k];
+        x[k] = 0;
+
+        for (int t = top; t < n_nodes; t++)
+        {
+            int j = pattern[t];
+            double l_kj = x[j]/value_[col_start[j]];
+            x[j] = 0;
+
+            for (int p = col_start[j]+1; p < next[j]; p++)
+                x[row_index[p]] -= value_[p]*l_kj;
+
+            d -= l_kj*l_kj;
+            value_[next[j]++] = l_kj;
+        }
+
+        if (d <= 0)
+            throw NotPositiveDefinite();
+
+        value_[col_start[k]] = sqrt(d);
+    }
+}
+
+
+void CholeskyFactor::solve (const DoubleVector &rhs, DoubleVector &solution) const
+{
+    int n_nodes = symbolic_->perm.size();
+    const std::vector<int> &col_start = symbolic_->col_start;
+    const std::vector<int> &row_index = symbolic_->row_index;
+
+    DoubleVector y(n_nodes);
+
+    for (int k = 0; k < n_nodes; k++)
+        y[k] = rhs[symbolic_->perm[k]];
+
+    // L*y = P*rhs
+    for (int j = 0; j < n_nodes; j++)
+    {
+        y[j] /= value_[col_start[j]];
+
+        for (int p = col_start[j]+1; p < col_start[j+1]; p++)
+            y[row_index[p]] -= value_[p]*y[j];
+    }
+
+    // L^T*(P*solution) = y
+    for (int j = n_nodes-1; j >= 0; j--)
+    {
+        for (int p = col_start[j]+1; p < col_start[j+1]; p++)
+            y[j] -= value_[p]*y[row_index[p]];
+
+        y[j] /= value_[col_start[j]];
+    }
+
+    solution.resize(n_nodes);
+
+    for (int k = 0; k < n_nodes; k++)
+        solution[symbolic_->perm[k]] = y[k];
+
+    // L read twice, with its rows, and the permutations
+    statsWork(4.0*value_.size(), 24.0*value_.size() + 48.0*n_nodes);
+}
+
+
+void sparseCholesky (const tSparseSystem &system, DoubleVector &solution,
+                     double void_parameter, bool verbose)
+{
+    if (verbose)
+        std::cout << "Beggining sparse Cholesky" << std::endl;
+
+    const CholeskyFactor *factor = findSetup<CholeskyFactor>(system);
+
+    if (factor == nullptr)
+    {
+        std::shared_ptr<CholeskySymbolic> symbolic =
+            findSharedSetup<CholeskySymbolic>(system);
+
+        if (not symbolic)
+            symbolic = addSetup(system, std::make_shared<CholeskySymbolic>(system));
+
+        factor = addSetup(system, new CholeskyFactor(system, symbolic));
+
+        if (verbose)
+            std::cout << " - Factorized with " << symbolic->getNonZeros()
+                      << " coefficients in L" << std::endl;
+    }
+
+    statsSetupDone();
+    factor->solve(system.rhs, solution);
+
+    if (verbose)
+        std::cout << " - Solved " << system.n_rows << " nodes" << std::endl;
+}
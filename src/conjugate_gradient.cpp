@@ -0,0 +1,274 @@
+#include <iostream>
+#include "solver.h"
+#include "solve_stats.h"
+
+
+static double dot (const DoubleVector &a, const DoubleVector &b)
+{
+    double sum = 0;
+
+    for (int i = 0; i < a.size(); i++)
+        sum += a[i]*b[i];
+
+    return sum;
+}
+
+
+void conjugateGradient (const tSparseSystem &system, DoubleVector &solution,
+                        double tolerance, bool verbose,
+                        const Preconditioner &preconditioner)
+{
+    int n_nodes = system.n_rows;
+    initialGuess(system, solution);
+
+    if (verbose)
+        std::cout << "Beggining preconditioned conjugate gradient" << std::endl;
+
+    // the preconditioner is built by the caller
+    statsSetupDone();
+
+    DoubleVector r, z, q;
+    multiply(system, solution, r);
+
+    for (int i = 0; i < n_nodes; i++)
+        r[i] = system.rhs[i] - r[i];
+
+    preconditioner.apply(r, z);
+
+    DoubleVector p = z;
+    double rz = dot(r, z);
+    double max_error = scaledResidual(system, r);
+    int n_iter = 0;
+
+    while (max_error > tolerance)
+    {
+        multiply(system, p, q);
+
+        double alpha = rz/dot(p, q);
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            solution[i] += alpha*p[i];
+            r[i] -= alpha*q[i];
+        }
+
+        max_error = scaledResidual(system, r);
+
+        // two dot products and three vector updates
+        statsWork(10.0*n_nodes, 104.0*n_nodes);
+        statsIteration(max_error);
+
+        if (verbose)
+            std::cout << " - Iteration " << n_iter <<" error: "
+                      << max_error << std::endl;
+
+        n_iter++;
+
+        if (max_error <= tolerance)
+            break;
+
+        preconditioner.apply(r, z);
+
+        double new_rz = dot(r, z);
+        double beta = new_rz/rz;
+        rz = new_rz;
+
+        for (int i = 0; i < n_nodes; i++)
+            p[i] = z[i] + beta*p[i];
+    }
+}
+
+
+void conjugateGradientJacobi (const tSparseSystem &system, DoubleVector &solution,
+                              double tolerance, bool verbose)
+{
+    conjugateGradient(system, solution, tolerance, verbose,
+                      JacobiPreconditioner(system));
+}
+
+
+void conjugateGradientSSOR (const tSparseSystem &system, DoubleVector &solution,
+                            double tolerance, bool verbose)
+{
+    conjugateGradient(system, solution, tolerance, verbose,
+                      SSORPreconditioner(system));
+}
+
+
+// The incomplete factorization is kept in the cache of the system, since it
+// costs as much as several iterations
+class ICSetup : public SolverSetup
+{
+public:
+
+    ICSetup (const tSparseSystem &system) : preconditioner(system) {}
+
+    ICPreconditioner preconditioner;
+};
+
+
+void conjugateGradientIC (const tSparseSystem &system, DoubleVector &solution,
+                          double tolerance, bool verbose)
+{
+    const ICSetup *setup = findSetup<ICSetup>(system);
+
+    if (setup == nullptr)
+        setup = addSetup(system, new ICSetup(system));
+
+    conjugateGradient(system, solution, tolerance, verbose,
+                      setup->preconditioner);
+}
+
+
+// result = A*x for n_rhs vectors stored interleaved
+static void multiplyBlock (const tSparseSystem &system, const DoubleVector &x,
+                           DoubleVector &result, int n_rhs)
+{
+    result.assign(system.n_rows*n_rhs, 0);
+
+    for (int i = 0; i < system.n_rows; i++)
+    {
+        double *result_i = &result[i*n_rhs];
+
+        for (int k = system.row_start[i]; k < system.row_start[i+1]; k++)
+        {
+            double a_ij = system.value[k];
+            const double *x_j = &x[system.col_index[k]*n_rhs];
+
+            for (int s = 0; s < n_rhs; s++)
+                result_i[s] += a_ij*x_j[s];
+        }
+    }
+}
+
+
+// dot[s] = sum over i of a[i*n_rhs + s]*b[i*n_rhs + s]
+static void dotBlock (const DoubleVector &a, const DoubleVector &b,
+                      DoubleVector &dot, int n_rhs)
+{
+    dot.assign(n_rhs, 0);
+
+    for (int i = 0; i < a.size(); i += n_rhs)
+        for (int s = 0; s < n_rhs; s++)
+            dot[s] += a[i+s]*b[i+s];
+}
+
+
+// error[s] = max |r_is/a_ii|, as scaledResidual for each vector
+static void scaledResidualBlock (const tSparseSystem &system, const DoubleVector &r,
+                                 DoubleVector &error, int n_rhs)
+{
+    error.assign(n_rhs, 0);
+
+    for (int i = 0; i < system.n_rows; i++)
+    {
+        double inv_diagonal = 1/system.value[system.row_start[i]];
+
+        for (int s = 0; s < n_rhs; s++)
+        {
+            double current_error = r[i*n_rhs + s]*inv_diagonal;
+
+            if (current_error < 0)
+                current_error *= -1;
+
+            if (current_error > error[s])
+                error[s] = current_error;
+        }
+    }
+}
+
+
+void blockConjugateGradient (const tSparseSystem &system, const DoubleVector &rhs,
+                             DoubleVector &solution, int n_rhs, double tolerance,
+                             bool verbose, const Preconditioner &preconditioner)
+{
+    int n_values = system.n_rows*n_rhs;
+
+    if (solution.size() != n_values)
+        solution.assign(n_values, 0);
+
+    if (verbose)
+        std::cout << "Beggining block conjugate gradient (" << n_rhs
+                  << " right hand sides)" << std::endl;
+
+    DoubleVector r, z, q;
+    multiplyBlock(system, solution, r, n_rhs);
+
+    for (int k = 0; k < n_values; k++)
+        r[k] = rhs[k] - r[k];
+
+    // converged vectors get alpha = beta = 0, so they stop changing
+    DoubleVector error;
+    scaledResidualBlock(system, r, error, n_rhs);
+
+    std::vector<char> active(n_rhs);
+    int n_active = 0;
+
+    for (int s = 0; s < n_rhs; s++)
+    {
+        active[s] = (error[s] > tolerance);
+        n_active += active[s];
+    }
+
+    preconditioner.applyBlock(r, z, n_rhs);
+
+    DoubleVector p = z;
+    DoubleVector rz, new_rz, pq;
+    DoubleVector alpha(n_rhs), beta(n_rhs);
+    dotBlock(r, z, rz, n_rhs);
+    int n_iter = 0;
+
+    while (n_active > 0)
+    {
+        multiplyBlock(system, p, q, n_rhs);
+        dotBlock(p, q, pq, n_rhs);
+
+        for (int s = 0; s < n_rhs; s++)
+            alpha[s] = (active[s] ? rz[s]/pq[s] : 0);
+
+        for (int k = 0; k < n_values; k += n_rhs)
+        {
+            for (int s = 0; s < n_rhs; s++)
+            {
+                solution[k+s] += alpha[s]*p[k+s];
+                r[k+s] -= alpha[s]*q[k+s];
+            }
+        }
+
+        scaledResidualBlock(system, r, error, n_rhs);
+
+        double max_error = 0;
+        n_active = 0;
+
+        for (int s = 0; s < n_rhs; s++)
+        {
+            active[s] = (active[s] and error[s] > tolerance);
+            n_active += active[s];
+
+            if (error[s] > max_error)
+                max_error = error[s];
+        }
+
+        if (verbose)
+            std::cout << " - Iteration " << n_iter <<" error: "
+                      << max_error << std::endl;
+
+        n_iter++;
+
+        if (n_active == 0)
+            break;
+
+        preconditioner.applyBlock(r, z, n_rhs);
+        dotBlock(r, z, new_rz, n_rhs);
+
+        for (int s = 0; s < n_rhs; s++)
+        {
+            beta[s] = (active[s] ? new_rz[s]/rz[s] : 0);
+            rz[s] = new_rz[s];
+        }
+
+        for (int k = 0; k < n_values; k += n_rhs)
+            for (int s = 0; s < n_rhs; s++)
+                p[k+s] = z[k+s] + beta[s]*p[k+s];
+    }
+}
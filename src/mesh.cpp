@@ -1,12 +1,123 @@
 #include "mesh.h"
+#include <algorithm>
+#include <exception>
 #include <iostream>
+#include <map>
+#include <math.h>
+#include <memory>
+#include <string.h>
+#include "checkpoint.h"
 #include "exceptions.h"
+#include "preconditioner.h"
+#include "solver.h"
+#include "thread_pool.h"
+
+// scenarios solved together by each task of solveMeshBatch
+#define BATCH_BLOCK_SIZE 8
+
+// nodes updated by each task of the explicit time steps
+#define EXPLICIT_CHUNK 4096
+// fraction of the stability limit used as sub-step by the explicit schemes
+#define EXPLICIT_SAFETY_FACTOR 0.95
+// limits of the change of the time step of solveTransitoryAdaptive. Steps are
+// only made longer if they can grow at least ADAPTIVE_MIN_GROWTH times, so
+// that the setups of the solver are not rebuilt for small gains
+#define ADAPTIVE_SAFETY_FACTOR 0.9
+#define ADAPTIVE_MAX_GROWTH 5.0
+#define ADAPTIVE_MAX_SHRINK 0.2
+#define ADAPTIVE_MIN_GROWTH 1.5
+
+
+// Forward Euler update T' = T + h*C^-1*(b - A*T) with all the coefficients
+// already scaled by h/C_i, stored as flat arrays. Neighbors are packed in
+// ELLPACK format: neighbor k of node i is column[k*n_nodes + i] with weight
+// weight[k*n_nodes + i], and nodes with fewer neighbors point to themselves
+// with weight zero, so every node does the same work
+typedef struct _tExplicitStencil
+{
+    int n_nodes;
+    int width;
+
+    DoubleVector self;   // 1 - h*a_ii/C_i
+    DoubleVector source; // h*b_i/C_i
+    std::vector<int> column;
+    DoubleVector weight; // -h*a_ij/C_i
+} tExplicitStencil;
+
+
+static void buildExplicitStencil (const tSparseSystem &system,
+                                  const DoubleVector &capacity, double h,
+                                  tExplicitStencil &stencil)
+{
+    int n_nodes = system.n_rows;
+    int width = 0;
+
+    for (int i = 0; i < n_nodes; i++)
+        if (system.row_start[i+1] - system.row_start[i] - 1 > width)
+            width = system.row_start[i+1] - system.row_start[i] - 1;
+
+    stencil.n_nodes = n_nodes;
+    stencil.width = width;
+    stencil.self.resize(n_nodes);
+    stencil.source.resize(n_nodes);
+    stencil.column.resize(width*n_nodes);
+    stencil.weight.assign(width*n_nodes, 0);
+
+    for (int i = 0; i < n_nodes; i++)
+    {
+        double scale = h/capacity[i];
+        int diagonal = system.row_start[i];
+
+        stencil.self[i] = 1 - scale*system.value[diagonal];
+        stencil.source[i] = scale*system.rhs[i];
+
+        for (int k = 0; k < width; k++)
+        {
+            int position = diagonal+1+k;
+
+            if (position < system.row_start[i+1])
+            {
+                stencil.column[k*n_nodes + i] = system.col_index[position];
+                stencil.weight[k*n_nodes + i] = -scale*system.value[position];
+            }
+            else
+            {
+                stencil.column[k*n_nodes + i] = i;
+            }
+        }
+    }
+}
+
+
+// Computes result = T + h*C^-1*(b - A*T) for the nodes begin ... end-1
+static void explicitEulerUpdate (const tExplicitStencil &stencil,
+                                 const DoubleVector &T, DoubleVector &result,
+                                 int begin, int end)
+{
+    int n_nodes = stencil.n_nodes;
+    const double *self = &stencil.self[0];
+    const double *source = &stencil.source[0];
+    const double *in = &T[0];
+    double *out = &result[0];
+
+    for (int i = begin; i < end; i++)
+        out[i] = self[i]*in[i] + source[i];
+
+    for (int k = 0; k < stencil.width; k++)
+    {
+        const int *column = &stencil.column[k*n_nodes];
+        const double *weight = &stencil.weight[k*n_nodes];
+
+        for (int i = begin; i < end; i++)
+            out[i] += weight[i]*in[column[i]];
+    }
+}
 
 
 Mesh::Mesh (const tMeshData *mesh) :
         n_volumes(mesh->n_volms), n_boundaries(mesh->n_boundaries),
-        problem_dim_(mesh->problem_dimensions),
-        node(mesh->n_volms+mesh->n_boundaries)
+        problem_dim_(mesh->problem_dimensions), n_faces_(2*problem_dim_),
+        checkpoint_each_(0)
 {
     // check mesh vectors are of correct size
     if (mesh->pos_volumes.size() != n_volumes or
@@ -29,56 +140,351 @@ Mesh::Mesh (const tMeshData *mesh) :
         throw UnconsistemNumberOfBoundaries();
     }
 
-    // build mesh of solid volumes
+    volume_.resize(n_volumes);
+    lambda_.resize(n_volumes);
+    qv_.resize(n_volumes);
+    rho_.resize(n_volumes);
+    cp_.resize(n_volumes);
+    position_.resize(n_volumes*problem_dim_);
+    surface_.resize(n_volumes*n_faces_);
+
+    // copy the data of the solid volumes
     for (int i = 0; i < n_volumes; i++)
     {
-        double volume = mesh->volms_data[i][0];
-        double lambda = mesh->volms_data[i][1];
-        double qv = mesh->volms_data[i][2];
-            
-        node[i] = new SolidVolume(problem_dim_, volume, lambda, qv,
-                            mesh->surface_volumes[i], i, mesh->pos_volumes[i]);
+        volume_[i] = mesh->volms_data[i][0];
+        lambda_[i] = mesh->volms_data[i][1];
+        qv_[i] = mesh->volms_data[i][2];
+        // density and specific heat are only needed by solveTransitory
+        bool has_capacity = (mesh->volms_data[i].size() >= 5);
+        rho_[i] = (has_capacity ? mesh->volms_data[i][3] : 0);
+        cp_[i] = (has_capacity ? mesh->volms_data[i][4] : 0);
+
+        for (int d = 0; d < problem_dim_; d++)
+            position_[i*problem_dim_ + d] = mesh->pos_volumes[i][d];
+
+        for (int j = 0; j < n_faces_; j++)
+            surface_[i*n_faces_ + j] = mesh->surface_volumes[i][j];
     }
 
-    // initialize boundary objects
+    boundary_type_.resize(n_boundaries);
+    boundary_T_.resize(n_boundaries);
+    boundary_coefficient_.resize(n_boundaries);
+
+    // boundaries: type, T_ext/T, alpha/distance
     for (int i = 0; i < n_boundaries; i++)
     {
-        VType node_type = VType(int(mesh->boundary_data[i][0]));
+        boundary_type_[i] = VType(int(mesh->boundary_data[i][0]));
 
-        // each type of volume needs to be initialized differently
-        if (node_type == convection_boundary)
+        if (boundary_type_[i] != convection_boundary and
+            boundary_type_[i] != fixed_T_boundary)
         {
-            double T_ext = mesh->boundary_data[i][1];
-            double alpha = mesh->boundary_data[i][2];
-
-            node[n_volumes+i] = new ConvectionBoundary(T_ext, alpha);
+            throw MeshUnknownVolume();
         }
-        else if (node_type == fixed_T_boundary)
-        {
-            double T = mesh->boundary_data[i][1];
-            double distance = mesh->boundary_data[i][2];
 
-            node[n_volumes+i] = new FixedTBoundary(T, distance);
-        }
-        else
+        boundary_T_[i] = mesh->boundary_data[i][1];
+        boundary_coefficient_[i] = mesh->boundary_data[i][2];
+    }
+
+    face_neighbor_.resize(n_volumes*n_faces_);
+
+    for (int i = 0; i < n_volumes; i++)
+        for (int j = 0; j < n_faces_; j++)
+            face_neighbor_[i*n_faces_ + j] = int(mesh->connectivity_volumes[i][j]);
+
+    buildFaces();
+}
+
+
+tMeshView meshView (const tCompactMeshData &mesh)
+{
+    tMeshView view;
+
+    view.problem_dimensions = mesh.problem_dimensions;
+    view.n_volms = mesh.n_volms;
+    view.n_boundaries = mesh.n_boundaries;
+    view.pos_volumes = mesh.pos_volumes.data();
+    view.surface_volumes = mesh.surface_volumes.data();
+    view.connectivity_volumes = mesh.connectivity_volumes.data();
+    view.volms_data = mesh.volms_data.data();
+    view.boundary_data = mesh.boundary_data.data();
+
+    return view;
+}
+
+
+// view of a compact mesh after checking the sizes of its arrays
+static tMeshView checkedView (const tCompactMeshData *mesh)
+{
+    long n_volumes = mesh->n_volms;
+    long n_faces = 2*mesh->problem_dimensions;
+
+    if (mesh->pos_volumes.size() != n_volumes*mesh->problem_dimensions or
+        mesh->surface_volumes.size() != n_volumes*n_faces or
+        mesh->connectivity_volumes.size() != n_volumes*n_faces)
+    {
+        throw UnconsistemProblemDimensions();
+    }
+
+    if (mesh->volms_data.size() != n_volumes*5)
+        throw UnconsistemNumberOfVolumes();
+
+    if (mesh->boundary_data.size() != mesh->n_boundaries*3)
+        throw UnconsistemNumberOfBoundaries();
+
+    return meshView(*mesh);
+}
+
+
+Mesh::Mesh (const tCompactMeshData *mesh) : Mesh(checkedView(mesh))
+{
+}
+
+
+Mesh::Mesh (const tMeshView &mesh) :
+        n_volumes(mesh.n_volms), n_boundaries(mesh.n_boundaries),
+        problem_dim_(mesh.problem_dimensions), n_faces_(2*problem_dim_),
+        checkpoint_each_(0)
+{
+    volume_.resize(n_volumes);
+    lambda_.resize(n_volumes);
+    qv_.resize(n_volumes);
+    rho_.resize(n_volumes);
+    cp_.resize(n_volumes);
+
+    for (int i = 0; i < n_volumes; i++)
+    {
+        const double *data = &mesh.volms_data[long(i)*5];
+
+        volume_[i] = data[0];
+        lambda_[i] = data[1];
+        qv_[i] = data[2];
+        rho_[i] = data[3];
+        cp_[i] = data[4];
+    }
+
+    long n_total_faces = long(n_volumes)*n_faces_;
+
+    position_.assign(mesh.pos_volumes, mesh.pos_volumes + long(n_volumes)*problem_dim_);
+    surface_.assign(mesh.surface_volumes, mesh.surface_volumes + n_total_faces);
+    face_neighbor_.assign(mesh.connectivity_volumes,
+                          mesh.connectivity_volumes + n_total_faces);
+
+    boundary_type_.resize(n_boundaries);
+    boundary_T_.resize(n_boundaries);
+    boundary_coefficient_.resize(n_boundaries);
+
+    for (int i = 0; i < n_boundaries; i++)
+    {
+        boundary_type_[i] = VType(int(mesh.boundary_data[i*3]));
+
+        if (boundary_type_[i] != convection_boundary and
+            boundary_type_[i] != fixed_T_boundary)
         {
             throw MeshUnknownVolume();
         }
+
+        boundary_T_[i] = mesh.boundary_data[i*3 + 1];
+        boundary_coefficient_[i] = mesh.boundary_data[i*3 + 2];
+    }
+
+    // a neighbor out of range would make the faces read out of the arrays
+    for (long f = 0; f < n_total_faces; f++)
+        if (face_neighbor_[f] < 0 or face_neighbor_[f] >= n_volumes + n_boundaries)
+            throw MeshUnknownVolume();
+
+    buildFaces();
+}
+
+
+void Mesh::buildFaces ()
+{
+    int n_total_faces = n_volumes*n_faces_;
+
+    face_kind_.resize(n_total_faces);
+    face_geometry_.resize(n_total_faces);
+    face_conductance_.resize(n_total_faces);
+
+    // now that all the nodes are known, build the faces
+    for (int f = 0; f < n_total_faces; f++)
+    {
+        int neighbor = face_neighbor_[f];
+
+        face_kind_[f] = (neighbor < n_volumes ? solid :
+                         boundary_type_[neighbor-n_volumes]);
+    }
+
+    for (int f = 0; f < face_conductance_.size(); f++)
+    {
+        face_geometry_[f] = faceGeometry(f);
+        face_conductance_[f] = faceConductance(f);
+    }
+
+    // faces of each boundary, counted first and then placed
+    boundary_face_start_.assign(n_boundaries+1, 0);
+
+    for (int f = 0; f < face_neighbor_.size(); f++)
+        if (face_kind_[f] != solid)
+            boundary_face_start_[face_neighbor_[f]-n_volumes+1]++;
+
+    for (int b = 0; b < n_boundaries; b++)
+        boundary_face_start_[b+1] += boundary_face_start_[b];
+
+    std::vector<int> next(boundary_face_start_.begin(), boundary_face_start_.end()-1);
+    boundary_face_.resize(boundary_face_start_.back());
+
+    for (int f = 0; f < face_neighbor_.size(); f++)
+        if (face_kind_[f] != solid)
+            boundary_face_[next[face_neighbor_[f]-n_volumes]++] = f;
+
+    // the system is assembled in the first solve
+    assembled_ = false;
+    is_dirty_.assign(n_volumes, 0);
+}
+
+
+double Mesh::faceGeometry (int face) const
+{
+    int i = face/n_faces_;
+    int neighbor = face_neighbor_[face];
+    double S = surface_[face];
+
+    if (face_kind_[face] == solid)
+        return S/distance(i, neighbor);
+    else if (face_kind_[face] == convection_boundary)
+        return S;
+    else
+        return S/boundary_coefficient_[neighbor-n_volumes];
+}
+
+
+double Mesh::faceConductance (int face) const
+{
+    int i = face/n_faces_;
+    int neighbor = face_neighbor_[face];
+
+    if (face_kind_[face] == solid)
+    {
+        // this is not exactly the average on the boundary of both volumes
+        // but in the midlle point between their centers, but it's close enough
+        double lambda = 2/(1/lambda_[i] + 1/lambda_[neighbor]);
+
+        return lambda*face_geometry_[face];
+    }
+    else if (face_kind_[face] == convection_boundary)
+    {
+        return boundary_coefficient_[neighbor-n_volumes]*face_geometry_[face];
+    }
+    else
+    {
+        return lambda_[i]*face_geometry_[face];
+    }
+}
+
+
+void Mesh::setLambda (int index, double new_lambda)
+{
+    lambda_[index] = new_lambda;
+
+    // the faces of the volume and the ones of its neighbors that point to it
+    markDirty(index);
+
+    for (int f = index*n_faces_; f < (index+1)*n_faces_; f++)
+    {
+        face_conductance_[f] = faceConductance(f);
+
+        if (face_kind_[f] != solid)
+            continue;
+
+        int neighbor = face_neighbor_[f];
+        markDirty(neighbor);
+
+        for (int g = neighbor*n_faces_; g < (neighbor+1)*n_faces_; g++)
+            if (face_neighbor_[g] == index)
+                face_conductance_[g] = faceConductance(g);
     }
+}
+
+
+double Mesh::distance (int i, int j) const
+{
+    double sum = 0;
 
-    // now that all the nodes are already generated, buil conectivities
+    for (int d = 0; d < problem_dim_; d++)
+        sum += pow(position_[j*problem_dim_ + d] - position_[i*problem_dim_ + d], 2);
+
+    return sqrt(sum);
+}
+
+
+void Mesh::assemble (tSparseSystem &system, const DoubleMatrix *boundary_data) const
+{
+    // each equation has at most one coefficient per face plus the diagonal
+    initSparseSystem(system, n_volumes, n_volumes*(n_faces_+1));
+
+    // equations with the format sum(a_i * x_i) = b_i, where the diagonal is the
+    // sum of the conductances of all faces and the neighbors get minus their
+    // conductance, so the system is symmetric positive definite
     for (int i = 0; i < n_volumes; i++)
     {
-        std::vector<const Volume*> boundaries(2*problem_dim_);
+        // the diagonal coefficient goes first in the row
+        addCoefficient(system, i, 0);
+        int diagonal = system.row_start.back();
 
-        // for each boundary index, get a pointer to it
-        for (int j = 0; j < problem_dim_*2; j++)
+        double a_ii = 0;
+        double b_i = qv_[i]*volume_[i];
+
+        for (int f = i*n_faces_; f < (i+1)*n_faces_; f++)
         {
-            int boundary_index = int(mesh->connectivity_volumes[i][j]);
-            boundaries[j] = node[boundary_index];
+            int neighbor = face_neighbor_[f];
+            double conductance = face_conductance_[f];
+
+            if (face_kind_[f] == solid)
+            {
+                addCoefficient(system, neighbor, -conductance);
+            }
+            else if (boundary_data != nullptr)
+            {
+                const DoubleVector &data = (*boundary_data)[neighbor-n_volumes];
+
+                conductance = boundaryConductance(f, data);
+                b_i += conductance*data[1];
+            }
+            else
+            {
+                b_i += conductance*boundary_T_[neighbor-n_volumes];
+            }
+
+            a_ii += conductance;
         }
-            
-        ((SolidVolume*)node[i])->setBoundaries(boundaries);
+
+        system.value[diagonal] = a_ii;
+        system.rhs[i] = b_i;
+        closeRow(system);
+    }
+}
+
+
+double Mesh::boundaryConductance (int face, const DoubleVector &data) const
+{
+    double S = surface_[face];
+
+    if (VType(int(data[0])) == convection_boundary)
+        return data[2]*S;
+    else
+        return lambda_[face/n_faces_]*S/data[2];
+}
+
+
+void Mesh::heatCapacities (DoubleVector &capacity) const
+{
+    capacity.resize(n_volumes);
+
+    for (int i = 0; i < n_volumes; i++)
+    {
+        capacity[i] = rho_[i]*cp_[i]*volume_[i];
+
+        if (not (capacity[i] > 0))
+            throw MissingHeatCapacity();
     }
 }
 
@@ -97,88 +503,1092 @@ int Mesh::getNumBoundaries () const
 
 void Mesh::setNodeData (const DoubleMatrix &node_data)
 {
-    //
+    if (node_data.size() != n_volumes)
+        throw UnconsistemNumberOfVolumes();
+
+    for (int i = 0; i < n_volumes; i++)
+    {
+        const DoubleVector &data = node_data[i];
+
+        if (data.size() < 3)
+            throw BadQuantityOfAttributes();
+
+        // volume and qv only change the independent term
+        if (data[0] != volume_[i] or data[2] != qv_[i])
+        {
+            volume_[i] = data[0];
+            qv_[i] = data[2];
+            markDirty(i);
+        }
+
+        if (data[1] != lambda_[i])
+            setLambda(i, data[1]);
+
+        // density and specific heat are only used by the transitories, which
+        // read them on each call
+        if (data.size() >= 5)
+        {
+            rho_[i] = data[3];
+            cp_[i] = data[4];
+        }
+    }
 }
 
 
 void Mesh::setBoundaryData (const DoubleMatrix &boundary_data)
 {
-    //
-}
+    if (boundary_data.size() != n_boundaries)
+        throw UnconsistemNumberOfBoundaries();
 
+    for (int b = 0; b < n_boundaries; b++)
+    {
+        const DoubleVector &data = boundary_data[b];
 
-double Mesh::solveMesh (void(*solver)(const DoubleMatrix&, DoubleVector&, double, bool),
-                      DoubleVector &T, double tolerance, bool check_solution,
-                      bool verbose)
-{
-    DoubleMatrix eq_sys(n_volumes, DoubleVector(n_volumes+1, 0));
+        if (data.size() < 3)
+            throw BadQuantityOfAttributes();
 
-    for (int i = 0; i < n_volumes; i++)
-        ((SolidVolume*)node[i])->getEquation(eq_sys[i]);
-    
-    solver(eq_sys, T, tolerance, verbose);
+        VType type = VType(int(data[0]));
 
-    double max_error = 0;
+        if (type != convection_boundary and type != fixed_T_boundary)
+            throw MeshUnknownVolume();
 
-    if (check_solution)
-    {
-        for (int i = 0; i < n_volumes; i++)
+        bool new_conductance = (type != boundary_type_[b] or
+                                data[2] != boundary_coefficient_[b]);
+
+        if (not new_conductance and data[1] == boundary_T_[b])
+            continue;
+
+        boundary_type_[b] = type;
+        boundary_T_[b] = data[1];
+        boundary_coefficient_[b] = data[2];
+
+        for (int k = boundary_face_start_[b]; k < boundary_face_start_[b+1]; k++)
         {
-            double this_error = -eq_sys[i][n_volumes];
+            int f = boundary_face_[k];
 
-            for (int j = 0; j < n_volumes; j++)
-                this_error += eq_sys[i][j]*T[j];
-            
-            if (i == 0 or this_error > max_error)
-                max_error = this_error;
+            if (new_conductance)
+            {
+                face_kind_[f] = type;
+                face_geometry_[f] = faceGeometry(f);
+                face_conductance_[f] = faceConductance(f);
+            }
+
+            markDirty(f/n_faces_);
         }
     }
-
-    return max_error;
 }
 
 
-void Mesh::solveTransitory (const DoubleVector &T0, DoubleMatrix &T,
-                            int time_steps, double t, int store_each)
+void Mesh::markDirty (int i)
 {
-    //
+    if (not is_dirty_[i])
+    {
+        is_dirty_[i] = 1;
+        dirty_rows_.push_back(i);
+    }
 }
 
 
-void Mesh::printMesh (int from, int to, bool only_volumes) const
+void Mesh::updateSystem ()
 {
-    if (to < 0)
-        to = n_volumes + (only_volumes ? 0 : n_boundaries);
-    
-    for (int i = from; i < to; i++)
-        node[i]->print(i);
+    if (not assembled_)
+    {
+        assemble(system_);
+        assembled_ = true;
+    }
+    else
+    {
+        bool new_coefficients = false;
+
+        for (int k = 0; k < dirty_rows_.size(); k++)
+            if (updateRow(system_, dirty_rows_[k]))
+                new_coefficients = true;
+
+        // the independent terms do not affect the setups of the solvers, and
+        // the positions of the coefficients never change
+        if (new_coefficients)
+            clearSetups(system_, true);
+    }
+
+    for (int k = 0; k < dirty_rows_.size(); k++)
+        is_dirty_[dirty_rows_[k]] = 0;
+
+    dirty_rows_.clear();
 }
 
 
-void Mesh::printNode (int index) const
+bool Mesh::updateRow (tSparseSystem &system, int i) const
 {
-    node[index]->print(index);
+    // the connectivity never changes, so the row keeps its coefficients
+    int first = system.row_start[i];
+    int last = system.row_start[i+1];
+    DoubleVector old_values(system.value.begin()+first, system.value.begin()+last);
+
+    for (int k = first; k < last; k++)
+        system.value[k] = 0;
+
+    double b_i = qv_[i]*volume_[i];
+
+    for (int f = i*n_faces_; f < (i+1)*n_faces_; f++)
+    {
+        int neighbor = face_neighbor_[f];
+        double conductance = face_conductance_[f];
+
+        system.value[first] += conductance;
+
+        if (face_kind_[f] == solid)
+        {
+            int k = first+1;
+
+            while (system.col_index[k] != neighbor)
+                k++;
+
+            system.value[k] -= conductance;
+        }
+        else
+        {
+            b_i += conductance*boundary_T_[neighbor-n_volumes];
+        }
+    }
+
+    system.rhs[i] = b_i;
+
+    for (int k = first; k < last; k++)
+        if (system.value[k] != old_values[k-first])
+            return true;
+
+    return false;
 }
 
 
-double Mesh::checkEnergyBalance (const DoubleVector &T) const
+double Mesh::solveMesh (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                      DoubleVector &T, double tolerance, bool check_solution,
+                      bool verbose, tSolveStats *stats)
 {
-    double max_value = ((SolidVolume*)node[0])->checkEnergyBalance(T);
+    double start = 0;
 
-    for (int i = 1; i < n_volumes; i++)
+    if (stats)
     {
-        double value = ((SolidVolume*)node[i])->checkEnergyBalance(T);
+        resetSolveStats(*stats);
+        start = statsClock();
+    }
+
+    // only the rows changed since the last solve are assembled again
+    updateSystem();
+
+    if (stats)
+        stats->assembly_time = statsClock() - start;
 
-        if (value > max_value)
-            max_value = value;
+    // iterative solvers start from the last solution if T brings no guess
+    if (T.size() != n_volumes and last_solution_.size() == n_volumes)
+        T = last_solution_;
+
+    {
+        SolveStatsScope scope(stats);
+        solver(system_, T, tolerance, verbose);
     }
 
-    return max_value;
+    last_solution_ = T;
+
+    double max_error = 0;
+
+    if (check_solution)
+    {
+        DoubleVector product;
+        multiply(system_, T, product);
+
+        for (int i = 0; i < n_volumes; i++)
+        {
+            double this_error = product[i] - system_.rhs[i];
+
+            if (this_error < 0)
+                this_error *= -1;
+
+            if (i == 0 or this_error > max_error)
+                max_error = this_error;
+        }
+    }
+
+    return max_error;
 }
 
 
-Mesh::~Mesh ()
+void Mesh::solveMeshBatch (const std::vector<DoubleMatrix> &boundary_data,
+                           DoubleMatrix &T, double tolerance, bool verbose)
 {
-    for (int i = 0; i < n_boundaries+n_volumes; i++)
-        delete node[i];
-}
\ No newline at end of file
+    int n_scenarios = boundary_data.size();
+
+    // scenarios whose boundaries have the same types and alpha/distance share
+    // the matrix of the system
+    std::map<DoubleVector, int> group_of_key;
+    std::vector<std::vector<int>> groups;
+
+    for (int s = 0; s < n_scenarios; s++)
+    {
+        if (boundary_data[s].size() != n_boundaries)
+            throw UnconsistemNumberOfBoundaries();
+
+        DoubleVector key(2*n_boundaries);
+
+        for (int b = 0; b < n_boundaries; b++)
+        {
+            const DoubleVector &data = boundary_data[s][b];
+
+            if (data.size() < 3)
+                throw BadQuantityOfAttributes();
+
+            VType type = VType(int(data[0]));
+
+            if (type != convection_boundary and type != fixed_T_boundary)
+                throw MeshUnknownVolume();
+
+            key[2*b] = data[0];
+            key[2*b+1] = data[2];
+        }
+
+        std::map<DoubleVector, int>::iterator it = group_of_key.find(key);
+
+        if (it == group_of_key.end())
+        {
+            group_of_key[key] = groups.size();
+            groups.push_back(std::vector<int>());
+            groups.back().push_back(s);
+        }
+        else
+        {
+            groups[it->second].push_back(s);
+        }
+    }
+
+    int n_groups = groups.size();
+
+    if (verbose)
+        std::cout << "Beggining batch of " << n_scenarios << " scenarios ("
+                  << n_groups << " different systems)" << std::endl;
+
+    T.resize(n_scenarios);
+
+    for (int s = 0; s < n_scenarios; s++)
+        T[s].resize(n_volumes);
+
+    ThreadPool &pool = defaultThreadPool();
+
+    // exceptions can not leave the threads of the pool, they are thrown later
+    std::vector<std::exception_ptr> errors(n_groups);
+
+    // assemble and factor the system of each group
+    std::vector<tSparseSystem> systems(n_groups);
+    std::vector<std::unique_ptr<ICPreconditioner>> preconditioners(n_groups);
+
+    pool.parallelFor(n_groups, 1, [&] (int begin, int end)
+    {
+        for (int g = begin; g < end; g++)
+        {
+            try
+            {
+                assemble(systems[g], &boundary_data[groups[g][0]]);
+                preconditioners[g].reset(new ICPreconditioner(systems[g]));
+            }
+            catch (...)
+            {
+                errors[g] = std::current_exception();
+            }
+        }
+    });
+
+    for (int g = 0; g < n_groups; g++)
+        if (errors[g])
+            std::rethrow_exception(errors[g]);
+
+    // blocks of up to BATCH_BLOCK_SIZE scenarios of the same group
+    std::vector<int> block_group;
+    std::vector<int> block_first;
+
+    for (int g = 0; g < n_groups; g++)
+    {
+        for (int k = 0; k < groups[g].size(); k += BATCH_BLOCK_SIZE)
+        {
+            block_group.push_back(g);
+            block_first.push_back(k);
+        }
+    }
+
+    pool.parallelFor(block_group.size(), 1, [&] (int begin, int end)
+    {
+        for (int block = begin; block < end; block++)
+        {
+            int g = block_group[block];
+            int first = block_first[block];
+            int n_rhs = std::min(BATCH_BLOCK_SIZE, int(groups[g].size()) - first);
+
+            // interleaved independent terms, only the boundary temperatures
+            // differ between the scenarios of a group
+            DoubleVector rhs(n_volumes*n_rhs);
+            DoubleVector solution;
+
+            for (int r = 0; r < n_rhs; r++)
+            {
+                const DoubleMatrix &data = boundary_data[groups[g][first+r]];
+
+                for (int i = 0; i < n_volumes; i++)
+                {
+                    double b_i = qv_[i]*volume_[i];
+
+                    for (int f = i*n_faces_; f < (i+1)*n_faces_; f++)
+                    {
+                        if (face_kind_[f] == solid)
+                            continue;
+
+                        const DoubleVector &boundary = data[face_neighbor_[f]-n_volumes];
+                        b_i += boundaryConductance(f, boundary)*boundary[1];
+                    }
+
+                    rhs[i*n_rhs + r] = b_i;
+                }
+            }
+
+            // all the scenarios start from the last solution of the mesh
+            if (last_solution_.size() == n_volumes)
+            {
+                solution.resize(n_volumes*n_rhs);
+
+                for (int i = 0; i < n_volumes; i++)
+                    for (int r = 0; r < n_rhs; r++)
+                        solution[i*n_rhs + r] = last_solution_[i];
+            }
+
+            blockConjugateGradient(systems[g], rhs, solution, n_rhs, tolerance,
+                                   false, *preconditioners[g]);
+
+            for (int r = 0; r < n_rhs; r++)
+            {
+                DoubleVector &scenario_T = T[groups[g][first+r]];
+
+                for (int i = 0; i < n_volumes; i++)
+                    scenario_T[i] = solution[i*n_rhs + r];
+            }
+        }
+    });
+}
+
+
+void Mesh::solveTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                            const DoubleVector &T0, DoubleMatrix &T,
+                            int time_steps, double t, int store_each,
+                            double tolerance, TimeScheme scheme, bool verbose)
+{
+    // only resized if needed, so the same matrix can be reused between calls
+    MatrixSink sink(T);
+
+    solveTransitory(solver, T0, sink, time_steps, t, store_each, tolerance,
+                    scheme, verbose);
+}
+
+
+void Mesh::solveTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                            const DoubleVector &T0, TransientSink &sink,
+                            int time_steps, double t, int store_each,
+                            double tolerance, TimeScheme scheme, bool verbose)
+{
+    if (T0.size() < n_volumes)
+        throw UnconsistemNumberOfVolumes();
+
+    if (not (t > 0) or time_steps <= 0 or store_each <= 0)
+        throw BadTransientParameters();
+
+    tTransientState state;
+    state.adaptive = false;
+    state.scheme = scheme;
+    state.t = t;
+    state.tolerance = tolerance;
+    state.step = 0;
+    state.time_steps = time_steps;
+    state.store_each = store_each;
+    state.time = state.h = state.time_tolerance = 0;
+    state.n_outputs = state.next_output = state.n_steps = state.n_rejected = 0;
+    state.fingerprint = 0;
+    state.T.assign(T0.begin(), T0.begin()+n_volumes);
+
+    runTransitory(solver, state, sink, verbose);
+}
+
+
+int Mesh::runTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                         tTransientState &state, TransientSink &sink,
+                         bool verbose)
+{
+    TimeScheme scheme = state.scheme;
+    int time_steps = state.time_steps;
+    int store_each = state.store_each;
+    double dt = state.t/time_steps;
+
+    updateSystem();
+    const tSparseSystem &steady = system_;
+
+    DoubleVector capacity;
+    heatCapacities(capacity);
+
+    unsigned long long fingerprint = transientFingerprint(steady, capacity);
+
+    if (state.fingerprint != 0 and state.fingerprint != fingerprint)
+        throw BadCheckpoint();
+
+    state.fingerprint = fingerprint;
+
+    std::unique_ptr<CheckpointWriter> checkpoints;
+
+    if (checkpoint_each_ > 0)
+        checkpoints.reset(new CheckpointWriter(checkpoint_path_));
+
+    // only the rows after the ones already stored
+    sink.begin(n_volumes, time_steps/store_each - state.step/store_each);
+
+    if (scheme == explicit_euler or scheme == explicit_rk2)
+    {
+        explicitTransitory(steady, capacity, state, sink, checkpoints.get(),
+                           verbose);
+
+        if (checkpoints)
+            checkpoints->finish();
+
+        sink.end();
+        return time_steps;
+    }
+
+    // weight of the new temperatures in the conduction terms
+    double theta = (scheme == crank_nicolson ? 0.5 : 1);
+
+    // C*(T' - T) = dt*(b - A*(theta*T' + (1-theta)*T)) gives the system
+    // (C + theta*dt*A)*T' = C*T - (1-theta)*dt*A*T + dt*b, whose coefficients
+    // do not change between steps
+    setStepSystem(steady, capacity, theta*dt);
+
+    if (verbose)
+        std::cout << "Beggining transitory ("
+                  << (scheme == crank_nicolson ? "Crank-Nicolson" : "implicit Euler")
+                  << ", dt = " << dt << " s)" << std::endl;
+
+    DoubleVector &current = state.T;
+    DoubleVector next;
+    DoubleVector &rhs = transient_system_.rhs;
+
+    for (int step = state.step+1; step <= time_steps; step++)
+    {
+        for (int i = 0; i < n_volumes; i++)
+        {
+            double conduction = 0;
+
+            if (theta < 1)
+                for (int k = steady.row_start[i]; k < steady.row_start[i+1]; k++)
+                    conduction += steady.value[k]*current[steady.col_index[k]];
+
+            rhs[i] = capacity[i]*current[i] - (1-theta)*dt*conduction +
+                     dt*steady.rhs[i];
+        }
+
+        // the previous step is the initial guess of iterative solvers
+        next = current;
+        solver(transient_system_, next, state.tolerance, false);
+        current.swap(next);
+        state.step = step;
+
+        if (step%store_each == 0)
+            sink.store(step*dt, current);
+
+        if (checkpoints and step%checkpoint_each_ == 0)
+        {
+            // the rows the checkpoint counts as stored must be delivered
+            sink.flush();
+            checkpoints->save(state);
+        }
+
+        if (verbose)
+            std::cout << " - Step " << step << " t = " << step*dt << " s" << std::endl;
+    }
+
+    if (checkpoints)
+        checkpoints->finish();
+
+    sink.end();
+
+    return time_steps;
+}
+
+
+int Mesh::solveTransitoryAdaptive (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                                   const DoubleVector &T0, DoubleMatrix &T,
+                                   double t, int n_outputs, double tolerance,
+                                   double time_tolerance, bool verbose)
+{
+    MatrixSink sink(T);
+
+    return solveTransitoryAdaptive(solver, T0, sink, t, n_outputs, tolerance,
+                                   time_tolerance, verbose);
+}
+
+
+int Mesh::solveTransitoryAdaptive (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                                   const DoubleVector &T0, TransientSink &sink,
+                                   double t, int n_outputs, double tolerance,
+                                   double time_tolerance, bool verbose)
+{
+    if (T0.size() < n_volumes)
+        throw UnconsistemNumberOfVolumes();
+
+    if (not (t > 0) or n_outputs <= 0 or not (time_tolerance > 0))
+        throw BadTransientParameters();
+
+    tTransientState state;
+    state.adaptive = true;
+    state.scheme = implicit_euler;
+    state.t = t;
+    state.tolerance = tolerance;
+    state.step = state.time_steps = state.store_each = 0;
+    state.time = 0;
+    state.h = -1; // chosen in the first step
+    state.time_tolerance = time_tolerance;
+    state.n_outputs = n_outputs;
+    state.next_output = state.n_steps = state.n_rejected = 0;
+    state.fingerprint = 0;
+    state.T.assign(T0.begin(), T0.begin()+n_volumes);
+
+    return runTransitoryAdaptive(solver, state, sink, verbose);
+}
+
+
+int Mesh::runTransitoryAdaptive (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                                 tTransientState &state, TransientSink &sink,
+                                 bool verbose)
+{
+    // TR-BDF2 with gamma = 2 - sqrt(2), where both stages have the matrix
+    // C + d*h*A with d = gamma/2 = (1-gamma)/(2-gamma)
+    const double gamma = 2 - sqrt(2.0);
+    const double d = gamma/2;
+    // weights of T_gamma and T_n in the BDF2 stage
+    const double w_gamma = 1/(gamma*(2-gamma));
+    const double w_n = (1-gamma)*(1-gamma)/(gamma*(2-gamma));
+    // constant of the local error estimate of Bank et al.
+    const double k_error = (-3*gamma*gamma + 4*gamma - 2)/(12*(2-gamma));
+
+    updateSystem();
+    const tSparseSystem &steady = system_;
+
+    DoubleVector capacity;
+    heatCapacities(capacity);
+
+    unsigned long long fingerprint = transientFingerprint(steady, capacity);
+
+    if (state.fingerprint != 0 and state.fingerprint != fingerprint)
+        throw BadCheckpoint();
+
+    state.fingerprint = fingerprint;
+
+    std::unique_ptr<CheckpointWriter> checkpoints;
+
+    if (checkpoint_each_ > 0)
+        checkpoints.reset(new CheckpointWriter(checkpoint_path_));
+
+    double t = state.t;
+    double tolerance = state.tolerance;
+    double time_tolerance = state.time_tolerance;
+    int n_outputs = state.n_outputs;
+
+    // only the rows after the ones already stored
+    sink.begin(n_volumes, n_outputs - state.next_output);
+
+    if (verbose)
+        std::cout << "Beggining adaptive transitory (TR-BDF2)" << std::endl;
+
+    DoubleVector &current = state.T;
+    DoubleVector stage, next, output(n_volumes);
+    DoubleVector f_current, f_stage, f_next;
+    DoubleVector &rhs = transient_system_.rhs;
+
+    // same values as f_next of the step that ended in current
+    timeDerivative(steady, capacity, current, f_current);
+
+    double output_interval = t/n_outputs;
+
+    if (state.h < 0)
+    {
+        // first step changes the fastest node by about time_tolerance
+        double max_rate = 0;
+
+        for (int i = 0; i < n_volumes; i++)
+        {
+            double rate = f_current[i];
+
+            if (rate < 0)
+                rate *= -1;
+
+            if (rate > max_rate)
+                max_rate = rate;
+        }
+
+        state.h = output_interval;
+
+        if (max_rate*state.h > time_tolerance)
+            state.h = time_tolerance/max_rate;
+    }
+
+    double &h = state.h;
+    double &time = state.time;
+    double system_h = -1; // step of the current coefficients of the system
+    int &next_output = state.next_output;
+    int &n_steps = state.n_steps;
+    int &n_rejected = state.n_rejected;
+
+    // the last output is at t itself, (k+1)*output_interval may round above it
+    auto output_time = [&] (int k) { return (k == n_outputs ? t : k*output_interval); };
+
+    while (next_output < n_outputs)
+    {
+        // the last step is shortened to end at t, without changing h
+        bool last_step = (time + h >= t);
+        double step_h = (last_step ? t - time : h);
+
+        if (not (step_h > 0))
+        {
+            // only a checkpoint that ends at t can leave outputs for later
+            if (time < t)
+                throw BadTransientParameters();
+
+            while (next_output < n_outputs)
+            {
+                next_output++;
+                sink.store(output_time(next_output), current);
+            }
+
+            break;
+        }
+
+        if (step_h != system_h)
+        {
+            setStepSystem(steady, capacity, d*step_h);
+            system_h = step_h;
+        }
+
+        // trapezoidal stage up to time + gamma*h
+        for (int i = 0; i < n_volumes; i++)
+            rhs[i] = capacity[i]*(current[i] + d*step_h*f_current[i]) +
+                     d*step_h*steady.rhs[i];
+
+        stage = current;
+        solver(transient_system_, stage, tolerance, false);
+
+        // BDF2 stage up to time + h
+        for (int i = 0; i < n_volumes; i++)
+            rhs[i] = capacity[i]*(w_gamma*stage[i] - w_n*current[i]) +
+                     d*step_h*steady.rhs[i];
+
+        next = stage;
+        solver(transient_system_, next, tolerance, false);
+
+        timeDerivative(steady, capacity, stage, f_stage);
+        timeDerivative(steady, capacity, next, f_next);
+
+        double error = 0;
+
+        for (int i = 0; i < n_volumes; i++)
+        {
+            double node_error = 2*k_error*step_h*(f_current[i]/gamma -
+                                    f_stage[i]/(gamma*(1-gamma)) +
+                                    f_next[i]/(1-gamma));
+
+            if (node_error < 0)
+                node_error *= -1;
+
+            if (node_error > error)
+                error = node_error;
+        }
+
+        // the error is O(h^3), so h*(tolerance/error)^(1/3) would just meet it
+        double factor = ADAPTIVE_SAFETY_FACTOR*
+                        pow(time_tolerance/(error > 0 ? error : 1e-300), 1.0/3);
+
+        if (factor > ADAPTIVE_MAX_GROWTH)
+            factor = ADAPTIVE_MAX_GROWTH;
+        if (factor < ADAPTIVE_MAX_SHRINK)
+            factor = ADAPTIVE_MAX_SHRINK;
+
+        if (error > time_tolerance)
+        {
+            h = step_h*factor;
+            n_rejected++;
+
+            if (verbose)
+                std::cout << " - Rejected step of " << step_h << " s" << std::endl;
+
+            continue;
+        }
+
+        // outputs inside the step, by cubic Hermite interpolation (all the
+        // ones left in the last step)
+        while (next_output < n_outputs and
+               (last_step or output_time(next_output+1) <= time + step_h*(1 + 1e-12)))
+        {
+            double s = (output_time(next_output+1) - time)/step_h;
+
+            if (s > 1)
+                s = 1;
+
+            double h00 = (2*s - 3)*s*s + 1;
+            double h10 = ((s - 2)*s + 1)*s*step_h;
+            double h01 = (3 - 2*s)*s*s;
+            double h11 = (s - 1)*s*s*step_h;
+
+            for (int i = 0; i < n_volumes; i++)
+                output[i] = h00*current[i] + h10*f_current[i] +
+                            h01*next[i] + h11*f_next[i];
+
+            next_output++;
+            sink.store(output_time(next_output), output);
+        }
+
+        time += step_h;
+        current.swap(next);
+        f_current.swap(f_next);
+        n_steps++;
+
+        if (verbose)
+            std::cout << " - Step " << n_steps << " t = " << time << " s, dt = "
+                      << step_h << " s, error: " << error << std::endl;
+
+        // small changes are not worth rebuilding the setups of the solver
+        if (factor < 1 or factor >= ADAPTIVE_MIN_GROWTH)
+            h = step_h*factor;
+
+        if (checkpoints and n_steps%checkpoint_each_ == 0)
+        {
+            sink.flush();
+            checkpoints->save(state);
+        }
+    }
+
+    if (checkpoints)
+        checkpoints->finish();
+
+    sink.end();
+
+    if (verbose)
+        std::cout << " - " << n_steps << " steps, " << n_rejected << " rejected"
+                  << std::endl;
+
+    return n_steps;
+}
+
+
+void Mesh::setCheckpoints (const std::string &path, int each_steps)
+{
+    checkpoint_path_ = path;
+    checkpoint_each_ = each_steps;
+}
+
+
+int Mesh::resumeTransitory (void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                            const std::string &path, TransientSink &sink,
+                            bool verbose)
+{
+    tTransientState state;
+    readCheckpoint(path, state);
+
+    if (state.T.size() != n_volumes)
+        throw BadCheckpoint();
+
+    if (verbose)
+        std::cout << "Resuming transitory from " << path << std::endl;
+
+    if (state.adaptive)
+        return runTransitoryAdaptive(solver, state, sink, verbose);
+    else
+        return runTransitory(solver, state, sink, verbose);
+}
+
+
+unsigned long long Mesh::transientFingerprint (const tSparseSystem &steady,
+                                               const DoubleVector &capacity) const
+{
+    // FNV-1a of the bytes of the values
+    unsigned long long hash = 14695981039346656037ULL;
+
+    const DoubleVector *arrays[3] = {&steady.value, &steady.rhs, &capacity};
+
+    for (int a = 0; a < 3; a++)
+        for (int k = 0; k < arrays[a]->size(); k++)
+        {
+            unsigned char bytes[sizeof(double)];
+            memcpy(bytes, &(*arrays[a])[k], sizeof(double));
+
+            for (int b = 0; b < sizeof(double); b++)
+            {
+                hash ^= bytes[b];
+                hash *= 1099511628211ULL;
+            }
+        }
+
+    // 0 means that a state has no fingerprint yet
+    return (hash == 0 ? 1 : hash);
+}
+
+
+void Mesh::setStepSystem (const tSparseSystem &steady,
+                          const DoubleVector &capacity, double factor)
+{
+    // the diagonal is the first coefficient of each row
+    tSparseSystem step_system = steady;
+
+    for (int k = 0; k < step_system.value.size(); k++)
+        step_system.value[k] *= factor;
+
+    for (int i = 0; i < n_volumes; i++)
+        step_system.value[step_system.row_start[i]] += capacity[i];
+
+    // as in solveMesh, the setups are kept if the coefficients did not change,
+    // and the structural ones if only their values did
+    if (step_system.row_start != transient_system_.row_start or
+        step_system.col_index != transient_system_.col_index)
+    {
+        transient_system_ = step_system;
+    }
+    else if (step_system.value != transient_system_.value)
+    {
+        transient_system_.value = step_system.value;
+        transient_system_.rhs = step_system.rhs;
+        clearSetups(transient_system_, true);
+    }
+}
+
+
+void Mesh::timeDerivative (const tSparseSystem &steady,
+                           const DoubleVector &capacity,
+                           const DoubleVector &T, DoubleVector &dT) const
+{
+    dT.resize(n_volumes);
+
+    for (int i = 0; i < n_volumes; i++)
+    {
+        double value = steady.rhs[i];
+
+        for (int k = steady.row_start[i]; k < steady.row_start[i+1]; k++)
+            value -= steady.value[k]*T[steady.col_index[k]];
+
+        dT[i] = value/capacity[i];
+    }
+}
+
+
+double Mesh::stableTimeStep () const
+{
+    tSparseSystem steady;
+    assemble(steady);
+
+    DoubleVector capacity;
+    heatCapacities(capacity);
+
+    return stableTimeStep(steady, capacity);
+}
+
+
+double Mesh::stableTimeStep (const tSparseSystem &steady,
+                             const DoubleVector &capacity) const
+{
+    // a_ii is the sum of the conductances of the faces of volume i, which is
+    // at least the sum of |a_ij|, so by Gershgorin the eigenvalues of C^-1*A
+    // are below max(2*a_ii/C_i). Forward Euler and RK2 are stable while
+    // dt*lambda <= 2 for all of them
+    double min_step = -1;
+
+    for (int i = 0; i < n_volumes; i++)
+    {
+        double step = capacity[i]/steady.value[steady.row_start[i]];
+
+        if (min_step < 0 or step < min_step)
+            min_step = step;
+    }
+
+    return min_step;
+}
+
+
+void Mesh::explicitTransitory (const tSparseSystem &steady,
+                               const DoubleVector &capacity,
+                               tTransientState &state, TransientSink &sink,
+                               CheckpointWriter *checkpoints, bool verbose) const
+{
+    TimeScheme scheme = state.scheme;
+    int time_steps = state.time_steps;
+    int store_each = state.store_each;
+    double dt = state.t/time_steps;
+
+    // each time step is split into the sub-steps needed to stay stable
+    double stable_step = EXPLICIT_SAFETY_FACTOR*stableTimeStep(steady, capacity);
+    int n_substeps = int(ceil(dt/stable_step));
+    double h = dt/n_substeps;
+
+    tExplicitStencil stencil;
+    buildExplicitStencil(steady, capacity, h, stencil);
+
+    if (verbose)
+        std::cout << "Beggining transitory ("
+                  << (scheme == explicit_rk2 ? "RK2" : "explicit Euler")
+                  << ", dt = " << dt << " s, " << n_substeps
+                  << " sub-steps of " << h << " s)" << std::endl;
+
+    ThreadPool &pool = defaultThreadPool();
+    DoubleVector &current = state.T;
+    DoubleVector next(n_volumes);
+    DoubleVector predicted(n_volumes);
+
+    for (int step = state.step+1; step <= time_steps; step++)
+    {
+        for (int sub = 0; sub < n_substeps; sub++)
+        {
+            if (scheme == explicit_rk2)
+            {
+                // Heun: T' = (T + E(E(T)))/2, where E is a forward Euler step
+                pool.parallelFor(n_volumes, EXPLICIT_CHUNK, [&] (int begin, int end)
+                {
+                    explicitEulerUpdate(stencil, current, predicted, begin, end);
+                });
+
+                pool.parallelFor(n_volumes, EXPLICIT_CHUNK, [&] (int begin, int end)
+                {
+                    explicitEulerUpdate(stencil, predicted, next, begin, end);
+
+                    for (int i = begin; i < end; i++)
+                        next[i] = 0.5*(current[i] + next[i]);
+                });
+            }
+            else
+            {
+                pool.parallelFor(n_volumes, EXPLICIT_CHUNK, [&] (int begin, int end)
+                {
+                    explicitEulerUpdate(stencil, current, next, begin, end);
+                });
+            }
+
+            current.swap(next);
+        }
+
+        state.step = step;
+
+        if (step%store_each == 0)
+            sink.store(step*dt, current);
+
+        if (checkpoints and step%checkpoint_each_ == 0)
+        {
+            sink.flush();
+            checkpoints->save(state);
+        }
+
+        if (verbose)
+            std::cout << " - Step " << step << " t = " << step*dt << " s" << std::endl;
+    }
+}
+
+
+void Mesh::printMesh (int from, int to, bool only_volumes) const
+{
+    if (to < 0)
+        to = n_volumes + (only_volumes ? 0 : n_boundaries);
+    
+    for (int i = from; i < to; i++)
+        printNode(i);
+}
+
+
+void Mesh::printNode (int index) const
+{
+    if (index >= n_volumes)
+    {
+        printBoundary(index);
+        return;
+    }
+
+    std::cout << " * (" << index << ") Solid volume:\n";
+    std::cout << "\tVolume: " << volume_[index] << " m^3\n";
+    std::cout << "\tInternal heat generated: " << qv_[index] << " W/m^3\n";
+    std::cout << "\tLambda: " << lambda_[index] << " W/(K*m^2)\n";
+    std::cout << "\tDensity: " << rho_[index] << " kg/m^3\n";
+    std::cout << "\tSpecific heat: " << cp_[index] << " J/(kg*K)\n";
+    std::cout << "\tPosition: ";
+
+    for (int i = 0; i < problem_dim_; i++)
+        std::cout << (i != 0 ? ", " : "") << position_[index*problem_dim_ + i];
+    std::cout << " m\n";
+
+    std::cout << "\tSurfaces: ";
+
+    for (int i = 0; i < n_faces_; i++)
+        std::cout << (i != 0 ? ", " : "") << surface_[index*n_faces_ + i];
+    std::cout << " m^2\n";
+
+    std::cout << "\tBoundaries:\n";
+
+    for (int i = 0; i < n_faces_; i++)
+    {
+        int f = index*n_faces_ + i;
+        int neighbor = face_neighbor_[f];
+
+        if (face_kind_[f] == solid)
+        {
+            std::cout << "\t   (" << i << ") Solid volume " << neighbor << "\n";
+        }
+        else if (face_kind_[f] == convection_boundary)
+        {
+            std::cout << "\t   (" << i << ") Convection boundary: alpha = " <<
+                boundary_coefficient_[neighbor-n_volumes] << " W/(K*m^2)    T_ext = " <<
+                boundary_T_[neighbor-n_volumes] << " K\n";
+        }
+        else
+        {
+            std::cout << "\t   (" << i << ") Fixed T boundary: T = " <<
+                boundary_T_[neighbor-n_volumes] << " K" << "   d = " <<
+                boundary_coefficient_[neighbor-n_volumes] << " m\n";
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+
+void Mesh::printBoundary (int index) const
+{
+    int b = index - n_volumes;
+
+    if (boundary_type_[b] == convection_boundary)
+        std::cout << " * (" << index << ") Convection boundary: alpha = " <<
+            boundary_coefficient_[b] << " W/(K*m^2)   T_ext = " <<
+            boundary_T_[b] << " K\n";
+    else
+        std::cout << " * (" << index << ")Fixed T boundary: T = " <<
+            boundary_T_[b] << " K \n";
+
+    std::cout << std::endl;
+}
+
+
+double Mesh::checkEnergyBalance (const DoubleVector &T) const
+{
+    double max_value = 0;
+
+    // heat entering each volume through its faces plus the generated one
+    for (int i = 0; i < n_volumes; i++)
+    {
+        double total = qv_[i]*volume_[i];
+
+        for (int f = i*n_faces_; f < (i+1)*n_faces_; f++)
+        {
+            int neighbor = face_neighbor_[f];
+            double T_neighbor = (face_kind_[f] == solid ? T[neighbor] :
+                                 boundary_T_[neighbor-n_volumes]);
+
+            total += face_conductance_[f]*(T_neighbor - T[i]);
+        }
+
+        if (i == 0 or total > max_value)
+            max_value = total;
+    }
+
+    return max_value;
+}
@@ -0,0 +1,416 @@
+#include "meshgen.h"
+#include <math.h>
+#include "exceptions.h"
+#include "thread_pool.h"
+
+// lines of cells given to each thread while generating a box
+#define BOX_LINES_CHUNK 64
+
+
+tFinParameters defaultFinParameters ()
+{
+    tFinParameters fin;
+
+    fin.Ra = 0.05;
+    fin.Rb = 0.13;
+    fin.e = 0.003;
+    fin.Ta = 200;
+    fin.Tg = 25;
+    fin.lambda = 22;
+    fin.rho = 7900;
+    fin.cp = 477;
+    fin.alpha = 100;
+    fin.n_elms = 100;
+
+    return fin;
+}
+
+
+void buildCylindricalFinMesh (tMeshData &mesh, const tFinParameters &fin)
+{
+    int n_dims = 2;
+    int n_elms = fin.n_elms;
+
+    double delta_r = (fin.Rb-fin.Ra)/n_elms;
+
+    mesh.problem_dimensions = n_dims;
+    mesh.n_volms = n_elms;
+    mesh.n_boundaries = 3; // one fixed T for the join with the tube, other for upper
+                           // and lower surfaces and other for the adiabatic tip
+
+    mesh.pos_volumes = DoubleMatrix(n_elms, DoubleVector(n_dims, fin.e/2));
+    mesh.surface_volumes = DoubleMatrix(n_elms, DoubleVector(n_dims*2, 0));
+    mesh.connectivity_volumes =  DoubleMatrix(n_elms, DoubleVector(n_dims*2, 0));
+    mesh.volms_data = DoubleMatrix(n_elms, DoubleVector(n_dims*4+3, 0));
+
+    // initialize all data for the volumes
+    for (int i = 0; i < n_elms; i++)
+    {
+        double r = fin.Ra + delta_r*(i + 0.5);
+        double vert_surface = M_PI*(pow(r+delta_r/2,2) - pow(r-delta_r/2,2));
+
+        // init pos_volues
+        mesh.pos_volumes[i][0] = r;
+
+        // init volms_data
+        mesh.volms_data[i][0] = fin.e*vert_surface;
+        mesh.volms_data[i][1] = fin.lambda;
+        mesh.volms_data[i][2] = 0;
+        mesh.volms_data[i][3] = fin.rho;
+        mesh.volms_data[i][4] = fin.cp;
+
+        // init surface_volms
+        mesh.surface_volumes[i][0] = 2*M_PI*(r-delta_r/2)*fin.e; // left surface
+        mesh.surface_volumes[i][1] = 2*M_PI*(r+delta_r/2)*fin.e; // right surface
+        mesh.surface_volumes[i][2] = vert_surface; // down surface
+        mesh.surface_volumes[i][3] = vert_surface; // up surface
+
+        // init connectivity_volumes
+
+        // joint with the tube
+        if (i == 0)
+        {
+            mesh.connectivity_volumes[i][0] = n_elms; // fiex t boundary node
+            mesh.connectivity_volumes[i][1] = i+1;  // second node
+        }
+        // tip of the fin
+        else if (i == n_elms-1)
+        {
+            mesh.connectivity_volumes[i][0] = i-1; // the volume before the last
+            mesh.connectivity_volumes[i][1] = n_elms+2; // adiabatic end node
+        }
+        // intermediate nodes
+        else
+        {
+            mesh.connectivity_volumes[i][0] = i-1;  // left volume
+            mesh.connectivity_volumes[i][1] = i+1;  // right volume
+        }
+
+        // upper and lower part are convective boundary
+        mesh.connectivity_volumes[i][2]  = n_elms+1;
+        mesh.connectivity_volumes[i][3] = n_elms+1;
+    }
+
+    // initialize boundary_data
+    mesh.boundary_data = DoubleMatrix({{fixed_T_boundary, fin.Ta, delta_r/2},       // n_elms:   fixed T boundary
+                                       {convection_boundary, fin.Tg, fin.alpha}, // n_elms+1: air convection
+                                       {convection_boundary, fin.Tg, 0.0}});     // n_elms+2: adiabatic tip
+}
+
+
+void buildTestMesh (tMeshData &mesh, int n_volms)
+{
+    const double widths[3] = {1.0, 2.0, 3.0};
+    const double lambdas[3] = {3.0, 5.0, 7.0};
+    const double qvs[3] = {-1.0, -2.0, -9.0};
+    const double T_exts[6] = {303.0, 302.0, 306.0, 308.0, 307.0, 309.0};
+
+    mesh.problem_dimensions = 2;
+    mesh.n_volms = n_volms;
+    mesh.n_boundaries = 2*n_volms + 2;
+
+    mesh.pos_volumes = DoubleMatrix(n_volms, DoubleVector(2, 0.5));
+    mesh.surface_volumes = DoubleMatrix(n_volms, DoubleVector(4, 1.0));
+    mesh.connectivity_volumes = DoubleMatrix(n_volms, DoubleVector(4, 0));
+    mesh.volms_data = DoubleMatrix(n_volms, DoubleVector(3, 0));
+    mesh.boundary_data = DoubleMatrix(mesh.n_boundaries, DoubleVector(3, 0));
+
+    double x = 0;
+
+    for (int i = 0; i < n_volms; i++)
+    {
+        double width = widths[i%3];
+
+        mesh.pos_volumes[i][0] = x + width/2;
+        x += width;
+
+        mesh.volms_data[i][0] = width;
+        mesh.volms_data[i][1] = lambdas[i%3];
+        mesh.volms_data[i][2] = qvs[i%3];
+
+        // lower and upper faces
+        mesh.surface_volumes[i][2] = width;
+        mesh.surface_volumes[i][3] = width;
+
+        mesh.connectivity_volumes[i][0] = (i == 0 ? n_volms : i-1);
+        mesh.connectivity_volumes[i][1] = (i == n_volms-1 ? n_volms + 2*n_volms + 1 : i+1);
+        mesh.connectivity_volumes[i][2] = n_volms + 2*i + 1;
+        mesh.connectivity_volumes[i][3] = n_volms + 2*i + 2;
+    }
+
+    mesh.boundary_data[0] = DoubleVector({fixed_T_boundary, 342.0, widths[0]/2});
+
+    for (int k = 0; k < 2*n_volms; k++)
+        mesh.boundary_data[k+1] = DoubleVector({convection_boundary, T_exts[k%6],
+                                                32.0 + k%6});
+
+    mesh.boundary_data[2*n_volms + 1] = DoubleVector({convection_boundary, 300.0, 0.0});
+}
+
+
+static void checkBox (const tBoxParameters &box, bool cylindrical)
+{
+    int n_dims = box.problem_dimensions;
+    int n_boundaries = box.boundary_data.size();
+
+    if (n_dims != 2 and n_dims != 3)
+        throw BadBoxParameters();
+
+    for (int d = 0; d < n_dims; d++)
+        if (box.n_cells[d] < 1 or box.length[d] <= 0)
+            throw BadBoxParameters();
+
+    if (cylindrical and box.origin[0] < 0)
+        throw BadBoxParameters();
+
+    for (int s = 0; s < 2*n_dims; s++)
+        if (box.side_boundary[s] < 0 or box.side_boundary[s] >= n_boundaries)
+            throw BadBoxParameters();
+
+    for (int p = 0; p < box.patches.size(); p++)
+        if (box.patches[p].side < 0 or box.patches[p].side >= 2*n_dims or
+            box.patches[p].boundary < 0 or box.patches[p].boundary >= n_boundaries)
+            throw BadBoxParameters();
+
+    for (int b = 0; b < n_boundaries; b++)
+        if (box.boundary_data[b].size() < 3)
+            throw BadQuantityOfAttributes();
+}
+
+
+// first and last cell of a block inside the box along axis d
+static void clipBlock (const tBoxParameters &box, const int *begin,
+                       const int *end, int d, int &first, int &last)
+{
+    first = (begin[d] > 0 ? begin[d] : 0);
+    last = (end[d] < box.n_cells[d] ? end[d] : box.n_cells[d]);
+}
+
+
+static void buildBoxMesh (tCompactMeshData &mesh, const tBoxParameters &box,
+                          bool cylindrical)
+{
+    checkBox(box, cylindrical);
+
+    int n_dims = box.problem_dimensions;
+    int n_faces = 2*n_dims;
+    int n[3] = {box.n_cells[0], box.n_cells[1], n_dims == 3 ? box.n_cells[2] : 1};
+    int n_volms = n[0]*n[1]*n[2];
+    int n_boundaries = box.boundary_data.size();
+
+    double origin[3] = {0, 0, 0};
+    double width[3] = {0, 0, 0};
+
+    for (int d = 0; d < n_dims; d++)
+    {
+        origin[d] = box.origin[d];
+        width[d] = box.length[d]/box.n_cells[d];
+    }
+
+    // a whole turn of a 3D cylindrical box links the first and last cells
+    // along theta instead of putting them on a boundary
+    bool ring = (cylindrical and n_dims == 3 and box.length[1] >= 2*M_PI - 1e-9);
+
+    if (ring and n[1] < 3)
+        throw BadBoxParameters();
+
+    mesh.problem_dimensions = n_dims;
+    mesh.n_volms = n_volms;
+    mesh.n_boundaries = n_boundaries;
+
+    mesh.pos_volumes.resize(long(n_volms)*n_dims);
+    mesh.surface_volumes.resize(long(n_volms)*n_faces);
+    mesh.connectivity_volumes.resize(long(n_volms)*n_faces);
+    mesh.volms_data.resize(long(n_volms)*5);
+
+    // each line of cells along the first axis
+    defaultThreadPool().parallelFor(n[1]*n[2], BOX_LINES_CHUNK, [&] (int begin, int end)
+    {
+        for (int line = begin; line < end; line++)
+        {
+            int b = line % n[1];
+            int c = line / n[1];
+            double y = origin[1] + width[1]*(b + 0.5);
+            double z = origin[2] + width[2]*(c + 0.5);
+
+            for (int a = 0; a < n[0]; a++)
+            {
+                long i = a + long(n[0])*line;
+                double x = origin[0] + width[0]*(a + 0.5);
+                double *position = &mesh.pos_volumes[i*n_dims];
+                double *surface = &mesh.surface_volumes[i*n_faces];
+                int *neighbor = &mesh.connectivity_volumes[i*n_faces];
+                double volume;
+
+                if (not cylindrical)
+                {
+                    volume = width[0]*width[1]*(n_dims == 3 ? width[2] : 1);
+
+                    for (int d = 0; d < n_dims; d++)
+                        surface[2*d] = surface[2*d+1] = volume/width[d];
+
+                    position[0] = x;
+                    position[1] = y;
+
+                    if (n_dims == 3)
+                        position[2] = z;
+                }
+                else
+                {
+                    double r_in = x - width[0]/2;
+                    double r_out = x + width[0]/2;
+                    double ring_area = r_out*r_out - r_in*r_in;
+
+                    if (n_dims == 2)
+                    {
+                        // revolution around the z axis, y is z
+                        volume = M_PI*ring_area*width[1];
+                        surface[0] = 2*M_PI*r_in*width[1];
+                        surface[1] = 2*M_PI*r_out*width[1];
+                        surface[2] = surface[3] = M_PI*ring_area;
+
+                        position[0] = x;
+                        position[1] = y;
+                    }
+                    else
+                    {
+                        // y is theta, and positions are cartesian so that the
+                        // distance between centers is right
+                        volume = ring_area/2*width[1]*width[2];
+                        surface[0] = r_in*width[1]*width[2];
+                        surface[1] = r_out*width[1]*width[2];
+                        surface[2] = surface[3] = width[0]*width[2];
+                        surface[4] = surface[5] = ring_area/2*width[1];
+
+                        position[0] = x*cos(y);
+                        position[1] = x*sin(y);
+                        position[2] = z;
+                    }
+                }
+
+                int cell[3] = {a, b, c};
+                long stride[3] = {1, n[0], long(n[0])*n[1]};
+
+                for (int d = 0; d < n_dims; d++)
+                {
+                    bool wrap = (ring and d == 1);
+
+                    if (cell[d] > 0)
+                        neighbor[2*d] = i - stride[d];
+                    else
+                        neighbor[2*d] = (wrap ? i + stride[d]*(n[d]-1) :
+                                         n_volms + box.side_boundary[2*d]);
+
+                    if (cell[d] < n[d]-1)
+                        neighbor[2*d+1] = i + stride[d];
+                    else
+                        neighbor[2*d+1] = (wrap ? i - stride[d]*(n[d]-1) :
+                                           n_volms + box.side_boundary[2*d+1]);
+                }
+
+                double *data = &mesh.volms_data[i*5];
+                data[0] = volume;
+                data[1] = box.lambda;
+                data[2] = box.qv;
+                data[3] = box.rho;
+                data[4] = box.cp;
+            }
+        }
+    });
+
+    // regions and patches only touch their own cells
+    for (int k = 0; k < box.regions.size(); k++)
+    {
+        const tBoxRegion &region = box.regions[k];
+        int first[3] = {0, 0, 0};
+        int last[3] = {1, 1, 1};
+
+        for (int d = 0; d < n_dims; d++)
+            clipBlock(box, region.begin, region.end, d, first[d], last[d]);
+
+        for (int c = first[2]; c < last[2]; c++)
+        {
+            for (int b = first[1]; b < last[1]; b++)
+            {
+                for (int a = first[0]; a < last[0]; a++)
+                {
+                    double *data = &mesh.volms_data[(a + n[0]*(b + long(n[1])*c))*5];
+                    data[1] = region.lambda;
+                    data[2] = region.qv;
+                    data[3] = region.rho;
+                    data[4] = region.cp;
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < box.patches.size(); k++)
+    {
+        const tBoxPatch &patch = box.patches[k];
+        int axis = patch.side/2;
+        int first[3] = {0, 0, 0};
+        int last[3] = {1, 1, 1};
+
+        for (int d = 0; d < n_dims; d++)
+            clipBlock(box, patch.begin, patch.end, d, first[d], last[d]);
+
+        // only the layer of cells on the side
+        first[axis] = (patch.side % 2 == 0 ? 0 : n[axis]-1);
+        last[axis] = first[axis] + 1;
+
+        if (ring and axis == 1)
+            continue;
+
+        for (int c = first[2]; c < last[2]; c++)
+            for (int b = first[1]; b < last[1]; b++)
+                for (int a = first[0]; a < last[0]; a++)
+                    mesh.connectivity_volumes[(a + n[0]*(b + long(n[1])*c))*n_faces +
+                                              patch.side] = n_volms + patch.boundary;
+    }
+
+    mesh.boundary_data.resize(n_boundaries*3);
+
+    for (int k = 0; k < n_boundaries; k++)
+    {
+        for (int j = 0; j < 3; j++)
+            mesh.boundary_data[k*3 + j] = box.boundary_data[k][j];
+
+        if (VType(int(box.boundary_data[k][0])) != fixed_T_boundary or
+            box.boundary_data[k][2] > 0)
+            continue;
+
+        // half the width of the cells of the first side that uses it, theta
+        // sides at the middle radius
+        int side = -1;
+
+        for (int s = 0; s < 2*n_dims and side < 0; s++)
+            if (box.side_boundary[s] == k)
+                side = s;
+
+        for (int p = 0; p < box.patches.size() and side < 0; p++)
+            if (box.patches[p].boundary == k)
+                side = box.patches[p].side;
+
+        if (side < 0)
+            continue;
+
+        double half_width = width[side/2]/2;
+
+        if (cylindrical and n_dims == 3 and side/2 == 1)
+            half_width *= box.origin[0] + box.length[0]/2;
+
+        mesh.boundary_data[k*3 + 2] = half_width;
+    }
+}
+
+
+void buildCartesianMesh (tCompactMeshData &mesh, const tBoxParameters &box)
+{
+    buildBoxMesh(mesh, box, false);
+}
+
+
+void buildCylindricalMesh (tCompactMeshData &mesh, const tBoxParameters &box)
+{
+    buildBoxMesh(mesh, box, true);
+}
@@ -0,0 +1,777 @@
+#include "meshio.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "exceptions.h"
+
+#define BINARY_HEADER_SIZE 64
+#define BINARY_ALIGNMENT 64
+#define BINARY_NAME_SIZE 48
+#define BINARY_ENTRY_SIZE (BINARY_NAME_SIZE + 24)
+
+static const char binary_magic[8] = {'H', 'E', 'F', 'E', 'S', 'T', 'O', '\0'};
+
+
+static bool littleEndianHost ()
+{
+    uint16_t one = 1;
+    return *reinterpret_cast<char*>(&one) == 1;
+}
+
+
+// reverses the bytes of count values of size bytes
+static void swapBytes (char *values, uint64_t count, int size)
+{
+    for (uint64_t k = 0; k < count; k++)
+        for (int b = 0; b < size/2; b++)
+            std::swap(values[k*size + b], values[k*size + size-1-b]);
+}
+
+
+static int typeSize (BinaryType type)
+{
+    switch (type)
+    {
+        case binary_uint8:
+            return 1;
+
+        case binary_float64:
+        case binary_int64:
+            return 8;
+
+        default:
+            return 4;
+    }
+}
+
+
+// little-endian integers of the header and the table
+static void putInteger (char *destination, uint64_t value, int size)
+{
+    for (int b = 0; b < size; b++)
+        destination[b] = char((value >> (8*b)) & 0xff);
+}
+
+
+static uint64_t getInteger (const char *source, int size)
+{
+    uint64_t value = 0;
+
+    for (int b = 0; b < size; b++)
+        value |= uint64_t(static_cast<unsigned char>(source[b])) << (8*b);
+
+    return value;
+}
+
+
+BinaryWriter::BinaryWriter (const std::string &path) :
+        position_(0), open_array_(false)
+{
+    file_ = fopen(path.c_str(), "wb");
+
+    if (file_ == nullptr)
+        throw BinaryFileError();
+
+    // the header is written again by close, once the table is known
+    char header[BINARY_HEADER_SIZE] = {0};
+    write(header, BINARY_HEADER_SIZE, 1);
+}
+
+
+void BinaryWriter::write (const void *values, uint64_t count, int size)
+{
+    if (count == 0)
+        return;
+
+    if (littleEndianHost() or size == 1)
+    {
+        if (fwrite(values, size, count, file_) != count)
+            throw BinaryFileError();
+    }
+    else
+    {
+        std::vector<char> swapped(static_cast<const char*>(values),
+                                  static_cast<const char*>(values) + count*size);
+        swapBytes(swapped.data(), count, size);
+
+        if (fwrite(swapped.data(), size, count, file_) != count)
+            throw BinaryFileError();
+    }
+
+    position_ += count*size;
+}
+
+
+void BinaryWriter::align ()
+{
+    char zeros[BINARY_ALIGNMENT] = {0};
+    int padding = (BINARY_ALIGNMENT - position_ % BINARY_ALIGNMENT) % BINARY_ALIGNMENT;
+
+    write(zeros, padding, 1);
+}
+
+
+void BinaryWriter::beginArray (const std::string &name, BinaryType type,
+                               int width)
+{
+    if (file_ == nullptr or open_array_ or name.size() >= BINARY_NAME_SIZE or
+        width < 1)
+    {
+        throw BinaryFileError();
+    }
+
+    for (int k = 0; k < arrays_.size(); k++)
+        if (arrays_[k].name == name)
+            throw BinaryFileError();
+
+    align();
+
+    tBinaryArray array;
+    array.name = name;
+    array.type = type;
+    array.width = width;
+    array.rows = 0;
+    array.offset = position_;
+
+    arrays_.push_back(array);
+    open_array_ = true;
+}
+
+
+void BinaryWriter::appendRows (const void *values, uint64_t rows)
+{
+    if (not open_array_)
+        throw BinaryFileError();
+
+    tBinaryArray &array = arrays_.back();
+
+    write(values, rows*array.width, typeSize(array.type));
+    array.rows += rows;
+}
+
+
+void BinaryWriter::endArray ()
+{
+    open_array_ = false;
+}
+
+
+void BinaryWriter::addArray (const std::string &name, const int32_t *values,
+                             uint64_t rows, int width)
+{
+    beginArray(name, binary_int32, width);
+    appendRows(values, rows);
+    endArray();
+}
+
+
+void BinaryWriter::addArray (const std::string &name, const float *values,
+                             uint64_t rows, int width)
+{
+    beginArray(name, binary_float32, width);
+    appendRows(values, rows);
+    endArray();
+}
+
+
+void BinaryWriter::addArray (const std::string &name, const double *values,
+                             uint64_t rows, int width)
+{
+    beginArray(name, binary_float64, width);
+    appendRows(values, rows);
+    endArray();
+}
+
+
+void BinaryWriter::addArray (const std::string &name, const uint8_t *values,
+                             uint64_t rows, int width)
+{
+    beginArray(name, binary_uint8, width);
+    appendRows(values, rows);
+    endArray();
+}
+
+
+void BinaryWriter::addArray (const std::string &name, const int64_t *values,
+                             uint64_t rows, int width)
+{
+    beginArray(name, binary_int64, width);
+    appendRows(values, rows);
+    endArray();
+}
+
+
+void BinaryWriter::close ()
+{
+    if (file_ == nullptr)
+        return;
+
+    align();
+    uint64_t table_position = position_;
+
+    // the table and the header are already little-endian bytes
+    std::vector<char> table(arrays_.size()*BINARY_ENTRY_SIZE, 0);
+
+    for (int k = 0; k < arrays_.size(); k++)
+    {
+        char *entry = &table[k*BINARY_ENTRY_SIZE];
+
+        memcpy(entry, arrays_[k].name.c_str(), arrays_[k].name.size());
+        putInteger(entry + BINARY_NAME_SIZE, arrays_[k].type, 4);
+        putInteger(entry + BINARY_NAME_SIZE + 4, arrays_[k].width, 4);
+        putInteger(entry + BINARY_NAME_SIZE + 8, arrays_[k].rows, 8);
+        putInteger(entry + BINARY_NAME_SIZE + 16, arrays_[k].offset, 8);
+    }
+
+    char header[BINARY_HEADER_SIZE] = {0};
+    memcpy(header, binary_magic, 8);
+    putInteger(header + 8, BINARY_FILE_VERSION, 4);
+    putInteger(header + 16, table_position, 8);
+    putInteger(header + 24, arrays_.size(), 8);
+
+    FILE *file = file_;
+    file_ = nullptr;
+
+    bool written = (fwrite(table.data(), 1, table.size(), file) == table.size() and
+                    fseek(file, 0, SEEK_SET) == 0 and
+                    fwrite(header, 1, BINARY_HEADER_SIZE, file) == BINARY_HEADER_SIZE);
+
+    if (fclose(file) != 0 or not written)
+        throw BinaryFileError();
+}
+
+
+BinaryWriter::~BinaryWriter ()
+{
+    // errors can not be reported from here, close must be called to see them
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+
+BinaryFile::BinaryFile (const std::string &path) : data_(nullptr), size_(0)
+{
+    int descriptor = open(path.c_str(), O_RDONLY);
+
+    if (descriptor < 0)
+        throw BinaryFileError();
+
+    struct stat info;
+
+    if (fstat(descriptor, &info) != 0)
+    {
+        ::close(descriptor);
+        throw BinaryFileError();
+    }
+
+    size_ = info.st_size;
+
+    if (size_ < BINARY_HEADER_SIZE)
+    {
+        ::close(descriptor);
+        throw BadBinaryFile();
+    }
+
+    // big-endian hosts need a private writable copy of the pages to swap the
+    // values in place
+    bool little_endian = littleEndianHost();
+    int protection = (little_endian ? PROT_READ : PROT_READ | PROT_WRITE);
+    void *data = mmap(nullptr, size_, protection, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+
+    if (data == MAP_FAILED)
+        throw BinaryFileError();
+
+    data_ = static_cast<char*>(data);
+
+    uint64_t table_position = getInteger(data_ + 16, 8);
+    uint64_t n_arrays = getInteger(data_ + 24, 8);
+
+    if (memcmp(data_, binary_magic, 8) != 0 or
+        getInteger(data_ + 8, 4) > BINARY_FILE_VERSION or
+        table_position > size_ or
+        n_arrays > (size_ - table_position)/BINARY_ENTRY_SIZE)
+    {
+        munmap(data_, size_);
+        throw BadBinaryFile();
+    }
+
+    for (uint64_t k = 0; k < n_arrays; k++)
+    {
+        const char *entry = data_ + table_position + k*BINARY_ENTRY_SIZE;
+        tBinaryArray array;
+
+        array.name = std::string(entry, strnlen(entry, BINARY_NAME_SIZE));
+        array.type = BinaryType(getInteger(entry + BINARY_NAME_SIZE, 4));
+        array.width = getInteger(entry + BINARY_NAME_SIZE + 4, 4);
+        array.rows = getInteger(entry + BINARY_NAME_SIZE + 8, 8);
+        array.offset = getInteger(entry + BINARY_NAME_SIZE + 16, 8);
+
+        bool valid_type = (array.type >= binary_int32 and
+                           array.type <= binary_int64);
+
+        // the values must be inside the file (bytes of a row in 64 bits, the
+        // width can be as big as INT_MAX)
+        if (not valid_type or array.width < 1 or array.offset > size_ or
+            array.rows > (size_ - array.offset)/
+                         (uint64_t(array.width)*typeSize(array.type)))
+        {
+            munmap(data_, size_);
+            throw BadBinaryFile();
+        }
+
+        if (not little_endian)
+            swapBytes(data_ + array.offset, array.rows*array.width,
+                      typeSize(array.type));
+
+        arrays_.push_back(array);
+    }
+}
+
+
+const std::vector<tBinaryArray>& BinaryFile::getArrays () const
+{
+    return arrays_;
+}
+
+
+const tBinaryArray* BinaryFile::findArray (const std::string &name) const
+{
+    for (int k = 0; k < arrays_.size(); k++)
+        if (arrays_[k].name == name)
+            return &arrays_[k];
+
+    return nullptr;
+}
+
+
+const void* BinaryFile::array (const std::string &name, BinaryType type,
+                               uint64_t &rows, int width) const
+{
+    const tBinaryArray *array = findArray(name);
+
+    if (array == nullptr or array->type != type or
+        (width != 0 and array->width != width))
+    {
+        throw BadBinaryFile();
+    }
+
+    rows = array->rows;
+
+    return data_ + array->offset;
+}
+
+
+const int32_t* BinaryFile::int32Array (const std::string &name, uint64_t &rows,
+                                       int width) const
+{
+    return static_cast<const int32_t*>(array(name, binary_int32, rows, width));
+}
+
+
+const float* BinaryFile::float32Array (const std::string &name, uint64_t &rows,
+                                       int width) const
+{
+    return static_cast<const float*>(array(name, binary_float32, rows, width));
+}
+
+
+const double* BinaryFile::float64Array (const std::string &name, uint64_t &rows,
+                                        int width) const
+{
+    return static_cast<const double*>(array(name, binary_float64, rows, width));
+}
+
+
+const uint8_t* BinaryFile::uint8Array (const std::string &name, uint64_t &rows,
+                                       int width) const
+{
+    return static_cast<const uint8_t*>(array(name, binary_uint8, rows, width));
+}
+
+
+const int64_t* BinaryFile::int64Array (const std::string &name, uint64_t &rows,
+                                       int width) const
+{
+    return static_cast<const int64_t*>(array(name, binary_int64, rows, width));
+}
+
+
+BinaryFile::~BinaryFile ()
+{
+    munmap(data_, size_);
+}
+
+
+static void writeDimensions (BinaryWriter &writer, unsigned int problem_dimensions,
+                             int n_volms, int n_boundaries)
+{
+    int32_t dimensions[3] = {int32_t(problem_dimensions), n_volms, n_boundaries};
+    writer.addArray("mesh.dimensions", dimensions, 1, 3);
+}
+
+
+void writeMesh (BinaryWriter &writer, const tCompactMeshData &mesh)
+{
+    int n_faces = 2*mesh.problem_dimensions;
+
+    writeDimensions(writer, mesh.problem_dimensions, mesh.n_volms, mesh.n_boundaries);
+    writer.addArray("mesh.position", mesh.pos_volumes.data(), mesh.n_volms,
+                    mesh.problem_dimensions);
+    writer.addArray("mesh.surface", mesh.surface_volumes.data(), mesh.n_volms,
+                    n_faces);
+    writer.addArray("mesh.connectivity", mesh.connectivity_volumes.data(),
+                    mesh.n_volms, n_faces);
+    writer.addArray("mesh.volumes", mesh.volms_data.data(), mesh.n_volms, 5);
+    writer.addArray("mesh.boundaries", mesh.boundary_data.data(),
+                    mesh.n_boundaries, 3);
+}
+
+
+void writeMesh (BinaryWriter &writer, const tMeshData &mesh)
+{
+    int n_dims = mesh.problem_dimensions;
+
+    if (n_dims < 1 or n_dims > 3)
+        throw UnconsistemProblemDimensions();
+
+    if (mesh.pos_volumes.size() != mesh.n_volms or
+        mesh.surface_volumes.size() != mesh.n_volms or
+        mesh.connectivity_volumes.size() != mesh.n_volms or
+        mesh.volms_data.size() != mesh.n_volms)
+    {
+        throw UnconsistemNumberOfVolumes();
+    }
+
+    for (int i = 0; i < mesh.n_volms; i++)
+        if (mesh.pos_volumes[i].size() != n_dims or
+            mesh.surface_volumes[i].size() != 2*n_dims or
+            mesh.connectivity_volumes[i].size() != 2*n_dims or
+            mesh.volms_data[i].size() < 3)
+        {
+            throw UnconsistemProblemDimensions();
+        }
+
+    if (mesh.boundary_data.size() != mesh.n_boundaries)
+        throw UnconsistemNumberOfBoundaries();
+
+    for (int i = 0; i < mesh.n_boundaries; i++)
+        if (mesh.boundary_data[i].size() < 3)
+            throw BadQuantityOfAttributes();
+
+    writeDimensions(writer, n_dims, mesh.n_volms, mesh.n_boundaries);
+
+    // row by row, each one is a vector of its own
+    writer.beginArray("mesh.position", binary_float64, n_dims);
+    for (int i = 0; i < mesh.n_volms; i++)
+        writer.appendRows(mesh.pos_volumes[i].data(), 1);
+    writer.endArray();
+
+    writer.beginArray("mesh.surface", binary_float64, 2*n_dims);
+    for (int i = 0; i < mesh.n_volms; i++)
+        writer.appendRows(mesh.surface_volumes[i].data(), 1);
+    writer.endArray();
+
+    writer.beginArray("mesh.connectivity", binary_int32, 2*n_dims);
+    for (int i = 0; i < mesh.n_volms; i++)
+    {
+        int32_t row[6];
+
+        for (int j = 0; j < 2*n_dims; j++)
+            row[j] = int32_t(mesh.connectivity_volumes[i][j]);
+
+        writer.appendRows(row, 1);
+    }
+    writer.endArray();
+
+    writer.beginArray("mesh.volumes", binary_float64, 5);
+    for (int i = 0; i < mesh.n_volms; i++)
+    {
+        double row[5] = {0, 0, 0, 0, 0};
+
+        for (int j = 0; j < 5 and j < mesh.volms_data[i].size(); j++)
+            row[j] = mesh.volms_data[i][j];
+
+        writer.appendRows(row, 1);
+    }
+    writer.endArray();
+
+    writer.beginArray("mesh.boundaries", binary_float64, 3);
+    for (int i = 0; i < mesh.n_boundaries; i++)
+        writer.appendRows(mesh.boundary_data[i].data(), 1);
+    writer.endArray();
+}
+
+
+tMeshView readMesh (const BinaryFile &file)
+{
+    uint64_t rows;
+    const int32_t *dimensions = file.int32Array("mesh.dimensions", rows, 3);
+
+    if (rows != 1 or (dimensions[0] != 1 and dimensions[0] != 2 and
+                      dimensions[0] != 3))
+    {
+        throw BadBinaryFile();
+    }
+
+    tMeshView view;
+    view.problem_dimensions = dimensions[0];
+    view.n_volms = dimensions[1];
+    view.n_boundaries = dimensions[2];
+
+    int n_dims = view.problem_dimensions;
+    uint64_t n_volms = view.n_volms;
+    uint64_t n_boundaries = view.n_boundaries;
+    uint64_t rows_position, rows_surface, rows_connectivity, rows_volumes;
+
+    view.pos_volumes = file.float64Array("mesh.position", rows_position, n_dims);
+    view.surface_volumes = file.float64Array("mesh.surface", rows_surface, 2*n_dims);
+    view.connectivity_volumes = file.int32Array("mesh.connectivity",
+                                                rows_connectivity, 2*n_dims);
+    view.volms_data = file.float64Array("mesh.volumes", rows_volumes, 5);
+    view.boundary_data = file.float64Array("mesh.boundaries", rows, 3);
+
+    if (rows_position != n_volms or rows_surface != n_volms or
+        rows_connectivity != n_volms or rows_volumes != n_volms or
+        rows != n_boundaries)
+    {
+        throw BadBinaryFile();
+    }
+
+    return view;
+}
+
+
+void writeField (BinaryWriter &writer, const std::string &name,
+                 const DoubleVector &values)
+{
+    writer.addArray(name, values.data(), values.size(), 1);
+}
+
+
+void writeTransient (BinaryWriter &writer, const std::string &name,
+                     const DoubleMatrix &values, const DoubleVector &times)
+{
+    int width = (values.empty() ? 1 : values[0].size());
+
+    writer.beginArray(name, binary_float64, width);
+
+    for (int k = 0; k < values.size(); k++)
+    {
+        if (values[k].size() != width)
+            throw BinaryFileError();
+
+        writer.appendRows(values[k].data(), 1);
+    }
+
+    writer.endArray();
+    writer.addArray(name + ".time", times.data(), times.size(), 1);
+}
+
+
+BinarySink::BinarySink (BinaryWriter &writer, const std::string &name,
+                        bool single_precision, bool delta) :
+        writer_(writer), name_(name), single_precision_(single_precision),
+        delta_(delta)
+{
+}
+
+
+void BinarySink::begin (int n_nodes, int n_snapshots)
+{
+    times_.clear();
+    offsets_.assign(1, 0);
+
+    if (delta_)
+    {
+        previous_.assign(n_nodes, 0);
+        writer_.beginArray(name_ + ".delta", binary_uint8, 1);
+    }
+    else
+    {
+        writer_.beginArray(name_, single_precision_ ? binary_float32 : binary_float64,
+                           n_nodes);
+    }
+}
+
+
+// bits of a value as stored, in the low bytes for float32
+static uint64_t valueBits (double value, bool single_precision)
+{
+    if (single_precision)
+    {
+        float single = float(value);
+        uint32_t bits;
+        memcpy(&bits, &single, 4);
+        return bits;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    return bits;
+}
+
+
+void BinarySink::store (double time, const DoubleVector &T)
+{
+    int n_nodes = T.size();
+
+    times_.push_back(time);
+
+    if (not delta_)
+    {
+        if (single_precision_)
+        {
+            single_.assign(T.begin(), T.end());
+            writer_.appendRows(single_.data(), 1);
+        }
+        else
+        {
+            writer_.appendRows(T.data(), 1);
+        }
+
+        return;
+    }
+
+    // a control byte for each two values with the number of bytes kept of
+    // each one (4 bits each), and then the bytes kept, lowest first
+    int n_control = (n_nodes+1)/2;
+    encoded_.assign(n_control, 0);
+
+    for (int i = 0; i < n_nodes; i++)
+    {
+        uint64_t bits = valueBits(T[i], single_precision_);
+        uint64_t change = bits ^ previous_[i];
+        previous_[i] = bits;
+
+        int n_bytes = 0;
+
+        while (n_bytes < 8 and (change >> (8*n_bytes)) != 0)
+            n_bytes++;
+
+        encoded_[i/2] |= uint8_t(n_bytes << (4*(i%2)));
+
+        for (int b = 0; b < n_bytes; b++)
+            encoded_.push_back(uint8_t(change >> (8*b)));
+    }
+
+    writer_.appendRows(encoded_.data(), encoded_.size());
+    offsets_.push_back(offsets_.back() + encoded_.size());
+}
+
+
+void BinarySink::end ()
+{
+    writer_.endArray();
+
+    if (delta_)
+    {
+        int32_t encoding[2] = {single_precision_ ? 4 : 8, int32_t(previous_.size())};
+
+        writer_.addArray(name_ + ".offset", offsets_.data(), offsets_.size(), 1);
+        writer_.addArray(name_ + ".encoding", encoding, 1, 2);
+    }
+
+    writer_.addArray(name_ + ".time", times_.data(), times_.size(), 1);
+}
+
+
+void readTransient (const BinaryFile &file, const std::string &name,
+                    DoubleMatrix &values, DoubleVector &times)
+{
+    uint64_t n_snapshots;
+    const double *time = file.float64Array(name + ".time", n_snapshots, 1);
+
+    times.assign(time, time + n_snapshots);
+    values.resize(n_snapshots);
+
+    const tBinaryArray *plain = file.findArray(name);
+
+    if (plain != nullptr)
+    {
+        int width = plain->width;
+
+        if (plain->rows != n_snapshots)
+            throw BadBinaryFile();
+
+        if (plain->type == binary_float32)
+        {
+            const float *data = file.float32Array(name, n_snapshots);
+
+            for (uint64_t s = 0; s < n_snapshots; s++)
+                values[s].assign(data + s*width, data + (s+1)*width);
+        }
+        else
+        {
+            const double *data = file.float64Array(name, n_snapshots);
+
+            for (uint64_t s = 0; s < n_snapshots; s++)
+                values[s].assign(data + s*width, data + (s+1)*width);
+        }
+
+        return;
+    }
+
+    uint64_t rows, n_bytes;
+    const int32_t *encoding = file.int32Array(name + ".encoding", rows, 2);
+    const int64_t *offset = file.int64Array(name + ".offset", rows, 1);
+    const uint8_t *delta = file.uint8Array(name + ".delta", n_bytes, 1);
+
+    int value_size = encoding[0];
+    int n_nodes = encoding[1];
+    int n_control = (n_nodes+1)/2;
+
+    if (rows != n_snapshots+1 or (value_size != 4 and value_size != 8))
+        throw BadBinaryFile();
+
+    std::vector<uint64_t> bits(n_nodes, 0);
+
+    for (uint64_t s = 0; s < n_snapshots; s++)
+    {
+        if (offset[s] < 0 or offset[s+1] > int64_t(n_bytes) or
+            offset[s+1] - offset[s] < n_control)
+        {
+            throw BadBinaryFile();
+        }
+
+        const uint8_t *control = delta + offset[s];
+        const uint8_t *byte = control + n_control;
+        const uint8_t *last = delta + offset[s+1];
+
+        values[s].resize(n_nodes);
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            int n_kept = (control[i/2] >> (4*(i%2))) & 0xf;
+            uint64_t change = 0;
+
+            if (n_kept > value_size or byte + n_kept > last)
+                throw BadBinaryFile();
+
+            for (int b = 0; b < n_kept; b++)
+                change |= uint64_t(*byte++) << (8*b);
+
+            bits[i] ^= change;
+
+            if (value_size == 4)
+            {
+                uint32_t single_bits = uint32_t(bits[i]);
+                float single;
+                memcpy(&single, &single_bits, 4);
+                values[s][i] = single;
+            }
+            else
+            {
+                memcpy(&values[s][i], &bits[i], 8);
+            }
+        }
+    }
+}
@@ -0,0 +1,758 @@
+#include "multigrid.h"
+#include <cstdlib>
+#include <iostream>
+#include <math.h>
+#include <set>
+#include "exceptions.h"
+#include "solve_stats.h"
+#include "solver.h"
+
+// levels with fewer nodes than this are not coarsened any further
+#define MG_COARSEST_SIZE 32
+// coarsest levels bigger than this are smoothed instead of factored
+#define MG_MAX_DENSE_SIZE 1024
+#define MG_COARSEST_SWEEPS 10
+// aggregation parameters: threshold of strong connections and maximum ratio
+// of coarse to fine nodes that is worth another level
+#define MG_STRENGTH_THRESHOLD 0.08
+#define MG_MIN_COARSENING 0.8
+
+
+// Deduces the number of nodes along each axis of a structured mesh numbered in
+// order from the index offsets of its coefficients (1, nx and nx*ny) and checks
+// every coefficient links two nodes that are neighbors in the grid
+static void findGridShape (const tSparseSystem &system, int shape[3])
+{
+    int n_nodes = system.n_rows;
+    std::set<int> offsets;
+
+    for (int i = 0; i < n_nodes; i++)
+        for (int k = system.row_start[i]+1; k < system.row_start[i+1]; k++)
+            offsets.insert(std::abs(system.col_index[k] - i));
+
+    std::vector<int> strides(offsets.begin(), offsets.end());
+
+    if (strides.size() > 3 or (strides.size() > 0 and strides[0] != 1))
+        throw NotStructuredSystem();
+
+    shape[0] = (strides.size() > 1 ? strides[1] : n_nodes);
+    shape[1] = (strides.size() > 2 ? strides[2]/strides[1] :
+                                     n_nodes/shape[0]);
+    shape[2] = n_nodes/(shape[0]*shape[1]);
+
+    if (shape[0]*shape[1]*shape[2] != n_nodes or
+        (strides.size() > 2 and strides[2] % strides[1] != 0))
+    {
+        throw NotStructuredSystem();
+    }
+
+    for (int i = 0; i < n_nodes; i++)
+    {
+        int x = i % shape[0];
+        int y = (i/shape[0]) % shape[1];
+
+        for (int k = system.row_start[i]+1; k < system.row_start[i+1]; k++)
+        {
+            int j = system.col_index[k];
+
+            // nodes at the end of a row are not neighbors of the next one
+            bool x_link = (j == i+1 and x < shape[0]-1) or (j == i-1 and x > 0);
+            bool y_link = (j == i+shape[0] and y < shape[1]-1) or
+                          (j == i-shape[0] and y > 0);
+            bool z_link = (j == i+shape[0]*shape[1] or j == i-shape[0]*shape[1]);
+
+            if (not (x_link or y_link or z_link))
+                throw NotStructuredSystem();
+        }
+    }
+}
+
+
+// Coarse nodes (up to two) that interpolate the fine node f of an axis with
+// n_coarse nodes, and their weights. Returns how many there are
+static int interpolation1D (int f, int n_fine, int n_coarse,
+                            int coarse[2], double weight[2])
+{
+    // axis that is not coarsened
+    if (n_coarse == n_fine)
+    {
+        coarse[0] = f;
+        weight[0] = 1;
+        return 1;
+    }
+
+    // the fine node sits at a quarter of the way from the center of its
+    // coarse node to the center of the neighbor one on its side
+    int parent = f/2;
+    int neighbor = (f % 2 == 0 ? parent-1 : parent+1);
+
+    coarse[0] = parent;
+
+    if (neighbor < 0 or neighbor >= n_coarse)
+    {
+        weight[0] = 1;
+        return 1;
+    }
+
+    weight[0] = 0.75;
+    coarse[1] = neighbor;
+    weight[1] = 0.25;
+
+    return 2;
+}
+
+
+void buildGeometricProlongations (const tSparseSystem &system,
+                                  std::vector<tProlongation> &prolongations,
+                                  std::vector<tSparseSystem> *coarse_systems)
+{
+    int shape[3];
+    findGridShape(system, shape);
+
+    prolongations.clear();
+
+    while (shape[0]*shape[1]*shape[2] > MG_COARSEST_SIZE and
+           (shape[0] > 2 or shape[1] > 2 or shape[2] > 2))
+    {
+        int coarse_shape[3];
+
+        for (int axis = 0; axis < 3; axis++)
+            coarse_shape[axis] = (shape[axis] > 2 ? (shape[axis]+1)/2 : shape[axis]);
+
+        tProlongation P;
+        P.n_fine = shape[0]*shape[1]*shape[2];
+        P.n_coarse = coarse_shape[0]*coarse_shape[1]*coarse_shape[2];
+        P.row_start.reserve(P.n_fine+1);
+        P.row_start.push_back(0);
+
+        for (int i = 0; i < P.n_fine; i++)
+        {
+            int position[3] = {i % shape[0], (i/shape[0]) % shape[1],
+                               i/(shape[0]*shape[1])};
+            int coarse[3][2];
+            double weight[3][2];
+            int count[3];
+
+            for (int axis = 0; axis < 3; axis++)
+                count[axis] = interpolation1D(position[axis], shape[axis],
+                                              coarse_shape[axis], coarse[axis],
+                                              weight[axis]);
+
+            // the weights of the grid are the product of the ones of each axis
+            for (int c = 0; c < count[2]; c++)
+                for (int b = 0; b < count[1]; b++)
+                    for (int a = 0; a < count[0]; a++)
+                    {
+                        P.col_index.push_back(coarse[0][a] + coarse_shape[0]*
+                                              (coarse[1][b] + coarse_shape[1]*coarse[2][c]));
+                        P.value.push_back(weight[0][a]*weight[1][b]*weight[2][c]);
+                    }
+
+            P.row_start.push_back(P.col_index.size());
+        }
+
+        prolongations.push_back(std::move(P));
+
+        for (int axis = 0; axis < 3; axis++)
+            shape[axis] = coarse_shape[axis];
+    }
+
+    // the interpolation does not depend on the coarse systems, they are only
+    // computed if asked for
+    if (coarse_systems == nullptr)
+        return;
+
+    coarse_systems->resize(prolongations.size());
+
+    for (int l = 0; l < prolongations.size(); l++)
+        galerkinProduct(l == 0 ? system : (*coarse_systems)[l-1], prolongations[l],
+                        (*coarse_systems)[l]);
+}
+
+
+void galerkinProduct (const tSparseSystem &fine, const tProlongation &P,
+                      tSparseSystem &coarse)
+{
+    // R = P^T by rows, that is, the fine nodes each coarse node restricts
+    std::vector<int> R_start(P.n_coarse+1, 0);
+    std::vector<int> R_index(P.col_index.size());
+    DoubleVector R_value(P.col_index.size());
+
+    for (int k = 0; k < P.col_index.size(); k++)
+        R_start[P.col_index[k]+1]++;
+
+    for (int I = 0; I < P.n_coarse; I++)
+        R_start[I+1] += R_start[I];
+
+    std::vector<int> next(R_start.begin(), R_start.end()-1);
+
+    for (int i = 0; i < P.n_fine; i++)
+    {
+        for (int k = P.row_start[i]; k < P.row_start[i+1]; k++)
+        {
+            int position = next[P.col_index[k]]++;
+            R_index[position] = i;
+            R_value[position] = P.value[k];
+        }
+    }
+
+    // row I of the product is the sum of R_Ii * A_ij * P_jJ, the coefficients
+    // are accumulated in a dense array and position tells where each column
+    // of the current row is stored
+    initSparseSystem(coarse, P.n_coarse, fine.col_index.size());
+    std::vector<int> position(P.n_coarse, -1);
+
+    for (int I = 0; I < P.n_coarse; I++)
+    {
+        int row_begin = coarse.col_index.size();
+
+        // the diagonal goes first
+        position[I] = row_begin;
+        coarse.col_index.push_back(I);
+        coarse.value.push_back(0);
+
+        for (int r = R_start[I]; r < R_start[I+1]; r++)
+        {
+            int i = R_index[r];
+
+            for (int k = fine.row_start[i]; k < fine.row_start[i+1]; k++)
+            {
+                int j = fine.col_index[k];
+                double weight = R_value[r]*fine.value[k];
+
+                for (int p = P.row_start[j]; p < P.row_start[j+1]; p++)
+                {
+                    int J = P.col_index[p];
+
+                    if (position[J] < row_begin)
+                    {
+                        position[J] = coarse.col_index.size();
+                        coarse.col_index.push_back(J);
+                        coarse.value.push_back(0);
+                    }
+
+                    coarse.value[position[J]] += weight*P.value[p];
+                }
+            }
+        }
+
+        closeRow(coarse);
+    }
+}
+
+
+void buildAggregationProlongations (const tSparseSystem &system,
+                                    std::vector<tProlongation> &prolongations,
+                                    std::vector<tSparseSystem> *coarse_systems)
+{
+    prolongations.clear();
+
+    // each level is aggregated from the coarse system of the previous one
+    std::vector<tSparseSystem> levels;
+    std::vector<tSparseSystem> &coarse = (coarse_systems ? *coarse_systems : levels);
+    coarse.clear();
+
+    const tSparseSystem *A = &system;
+
+    while (A->n_rows > MG_COARSEST_SIZE)
+    {
+        int n_nodes = A->n_rows;
+
+        // strong connections, the diagonal (first in the row) is never strong
+        std::vector<char> strong(A->col_index.size(), 0);
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            double a_ii = A->value[A->row_start[i]];
+
+            for (int k = A->row_start[i]+1; k < A->row_start[i+1]; k++)
+            {
+                int j = A->col_index[k];
+                double a_jj = A->value[A->row_start[j]];
+
+                strong[k] = (A->value[k]*A->value[k] >=
+                             MG_STRENGTH_THRESHOLD*MG_STRENGTH_THRESHOLD*a_ii*a_jj);
+            }
+        }
+
+        // first pass, nodes whose strong neighbors are all free are grouped
+        // with them into a new aggregate
+        std::vector<int> aggregate(n_nodes, -1);
+        int n_aggregates = 0;
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            bool free_neighborhood = (aggregate[i] < 0);
+            bool has_strong = false;
+
+            for (int k = A->row_start[i]+1; k < A->row_start[i+1] and
+                                            free_neighborhood; k++)
+            {
+                if (strong[k])
+                {
+                    has_strong = true;
+                    free_neighborhood = (aggregate[A->col_index[k]] < 0);
+                }
+            }
+
+            if (not free_neighborhood or not has_strong)
+                continue;
+
+            aggregate[i] = n_aggregates;
+
+            for (int k = A->row_start[i]+1; k < A->row_start[i+1]; k++)
+                if (strong[k])
+                    aggregate[A->col_index[k]] = n_aggregates;
+
+            n_aggregates++;
+        }
+
+        // second pass, the remaining nodes join the aggregate of the neighbor
+        // they are most strongly connected to (marked with -2 meanwhile so
+        // that they are not taken as aggregated by their neighbors)
+        std::vector<int> joins(n_nodes, -1);
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            if (aggregate[i] >= 0)
+                continue;
+
+            double strongest = 0;
+
+            for (int k = A->row_start[i]+1; k < A->row_start[i+1]; k++)
+            {
+                int j = A->col_index[k];
+                double connection = (A->value[k] < 0 ? -A->value[k] : A->value[k]);
+
+                if (strong[k] and aggregate[j] >= 0 and connection > strongest)
+                {
+                    strongest = connection;
+                    joins[i] = aggregate[j];
+                }
+            }
+        }
+
+        for (int i = 0; i < n_nodes; i++)
+            if (aggregate[i] < 0 and joins[i] >= 0)
+                aggregate[i] = joins[i];
+
+        // third pass, what is left forms aggregates with its free neighbors
+        for (int i = 0; i < n_nodes; i++)
+        {
+            if (aggregate[i] >= 0)
+                continue;
+
+            aggregate[i] = n_aggregates;
+
+            for (int k = A->row_start[i]+1; k < A->row_start[i+1]; k++)
+                if (strong[k] and aggregate[A->col_index[k]] < 0)
+                    aggregate[A->col_index[k]] = n_aggregates;
+
+            n_aggregates++;
+        }
+
+        // not worth another level if it barely reduces the number of nodes
+        if (n_aggregates > MG_MIN_COARSENING*n_nodes)
+            break;
+
+        // damping of the Jacobi step, 4/3 over a bound of the spectral radius
+        // of D^-1*A given by its largest absolute row sum
+        double spectral_radius = 0;
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            double row_sum = 0;
+
+            for (int k = A->row_start[i]; k < A->row_start[i+1]; k++)
+                row_sum += (A->value[k] < 0 ? -A->value[k] : A->value[k]);
+
+            row_sum /= A->value[A->row_start[i]];
+
+            if (row_sum > spectral_radius)
+                spectral_radius = row_sum;
+        }
+
+        double omega = 4.0/(3.0*spectral_radius);
+
+        // P = (I - w*D^-1*A) * P_tentative, where P_tentative has a one in
+        // the column of the aggregate of each node
+        tProlongation P;
+        P.n_fine = n_nodes;
+        P.n_coarse = n_aggregates;
+        P.row_start.reserve(n_nodes+1);
+        P.row_start.push_back(0);
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            int row_begin = P.col_index.size();
+            double scale = omega/A->value[A->row_start[i]];
+
+            P.col_index.push_back(aggregate[i]);
+            P.value.push_back(1);
+
+            for (int k = A->row_start[i]; k < A->row_start[i+1]; k++)
+            {
+                int J = aggregate[A->col_index[k]];
+                int position = row_begin;
+
+                while (position < P.col_index.size() and P.col_index[position] != J)
+                    position++;
+
+                if (position == P.col_index.size())
+                {
+                    P.col_index.push_back(J);
+                    P.value.push_back(0);
+                }
+
+                P.value[position] -= scale*A->value[k];
+            }
+
+            P.row_start.push_back(P.col_index.size());
+        }
+
+        tSparseSystem next;
+        galerkinProduct(*A, P, next);
+
+        prolongations.push_back(std::move(P));
+        coarse.push_back(std::move(next));
+        A = &coarse.back();
+    }
+}
+
+
+////////////////////////////////////////////////////////////////
+
+
+MultigridHierarchy::MultigridHierarchy (const tSparseSystem &system,
+                                        std::vector<tProlongation> &prolongations,
+                                        std::vector<tSparseSystem> &coarse) :
+        rhs_(prolongations.size()+1), solution_(prolongations.size()+1),
+        residual_(prolongations.size()+1)
+{
+    prolongations_.swap(prolongations);
+    coarse_.swap(coarse);
+
+    if (coarse_.size() != prolongations_.size())
+    {
+        coarse_.resize(prolongations_.size());
+
+        for (int l = 0; l < prolongations_.size(); l++)
+            galerkinProduct(l == 0 ? system : coarse_[l-1], prolongations_[l],
+                            coarse_[l]);
+    }
+
+    for (int l = 0; l < getNumLevels(); l++)
+    {
+        int n_nodes = (l == 0 ? system.n_rows : coarse_[l-1].n_rows);
+
+        rhs_[l].resize(n_nodes);
+        solution_[l].resize(n_nodes);
+        residual_[l].resize(n_nodes);
+    }
+
+    // dense Cholesky factorization of the coarsest level
+    const tSparseSystem &coarsest = (coarse_.empty() ? system : coarse_.back());
+    int n = coarsest.n_rows;
+
+    if (n > MG_MAX_DENSE_SIZE)
+        return;
+
+    DoubleVector &L = coarsest_factor_;
+    L.assign(n*n, 0);
+
+    for (int i = 0; i < n; i++)
+        for (int k = coarsest.row_start[i]; k < coarsest.row_start[i+1]; k++)
+            L[i*n + coarsest.col_index[k]] += coarsest.value[k];
+
+    for (int j = 0; j < n; j++)
+    {
+        double pivot = L[j*n + j];
+
+        for (int k = 0; k < j; k++)
+            pivot -= L[j*n + k]*L[j*n + k];
+
+        if (not (pivot > 0))
+            throw NotPositiveDefinite();
+
+        L[j*n + j] = sqrt(pivot);
+
+        for (int i = j+1; i < n; i++)
+        {
+            double value = L[i*n + j];
+
+            for (int k = 0; k < j; k++)
+                value -= L[i*n + k]*L[j*n + k];
+
+            L[i*n + j] = value/L[j*n + j];
+        }
+    }
+}
+
+
+int MultigridHierarchy::getNumLevels () const
+{
+    return coarse_.size()+1;
+}
+
+
+void MultigridHierarchy::cycle (const tSparseSystem &system,
+                                const DoubleVector &rhs, DoubleVector &solution,
+                                CycleType type, int n_smooth) const
+{
+    rhs_[0] = rhs;
+    solution_[0].swap(solution);
+
+    cycle(system, 0, type, n_smooth);
+
+    solution_[0].swap(solution);
+}
+
+
+void MultigridHierarchy::cycle (const tSparseSystem &system, int level,
+                                CycleType type, int n_smooth) const
+{
+    if (level == getNumLevels()-1)
+    {
+        solveCoarsest(system);
+        return;
+    }
+
+    const tSparseSystem &A = (level == 0 ? system : coarse_[level-1]);
+    const tProlongation &P = prolongations_[level];
+    DoubleVector &x = solution_[level];
+    DoubleVector &r = residual_[level];
+
+    for (int s = 0; s < n_smooth; s++)
+        gaussSeidelSweep(A, rhs_[level], x);
+
+    // restrict the residual to the coarser level
+    multiply(A, x, r);
+
+    for (int i = 0; i < A.n_rows; i++)
+        r[i] = rhs_[level][i] - r[i];
+
+    DoubleVector &coarse_rhs = rhs_[level+1];
+    coarse_rhs.assign(coarse_rhs.size(), 0);
+
+    for (int i = 0; i < P.n_fine; i++)
+        for (int k = P.row_start[i]; k < P.row_start[i+1]; k++)
+            coarse_rhs[P.col_index[k]] += P.value[k]*r[i];
+
+    // residual, restriction and the later interpolation
+    statsWork(A.n_rows + 4.0*P.value.size(),
+              24.0*A.n_rows + 40.0*P.value.size());
+
+    // solve the error at the coarser level
+    DoubleVector &coarse_x = solution_[level+1];
+    coarse_x.assign(coarse_x.size(), 0);
+
+    if (type == f_cycle)
+    {
+        cycle(system, level+1, f_cycle, n_smooth);
+        cycle(system, level+1, v_cycle, n_smooth);
+    }
+    else
+    {
+        cycle(system, level+1, v_cycle, n_smooth);
+    }
+
+    // correct with the interpolated error
+    for (int i = 0; i < P.n_fine; i++)
+        for (int k = P.row_start[i]; k < P.row_start[i+1]; k++)
+            x[i] += P.value[k]*coarse_x[P.col_index[k]];
+
+    for (int s = 0; s < n_smooth; s++)
+        gaussSeidelSweep(A, rhs_[level], x, true);
+}
+
+
+void MultigridHierarchy::solveCoarsest (const tSparseSystem &system) const
+{
+    const DoubleVector &b = rhs_.back();
+    DoubleVector &x = solution_.back();
+    int n = b.size();
+
+    // too big to be factored, just smooth it
+    if (coarsest_factor_.empty())
+    {
+        const tSparseSystem &A = (coarse_.empty() ? system : coarse_.back());
+
+        for (int s = 0; s < MG_COARSEST_SWEEPS; s++)
+        {
+            gaussSeidelSweep(A, b, x);
+            gaussSeidelSweep(A, b, x, true);
+        }
+
+        return;
+    }
+
+    const DoubleVector &L = coarsest_factor_;
+
+    // half of the dense factor read in each substitution
+    statsWork(2.0*n*n, 8.0*n*n);
+
+    for (int i = 0; i < n; i++)
+    {
+        double value = b[i];
+
+        for (int k = 0; k < i; k++)
+            value -= L[i*n + k]*x[k];
+
+        x[i] = value/L[i*n + i];
+    }
+
+    for (int i = n-1; i >= 0; i--)
+    {
+        double value = x[i];
+
+        for (int k = i+1; k < n; k++)
+            value -= L[k*n + i]*x[k];
+
+        x[i] = value/L[i*n + i];
+    }
+}
+
+
+GeometricMultigridSetup::GeometricMultigridSetup (const tSparseSystem &system,
+                                                  std::vector<tProlongation> &prolongations,
+                                                  std::vector<tSparseSystem> &coarse) :
+        MultigridHierarchy(system, prolongations, coarse)
+{
+    //
+}
+
+
+AlgebraicMultigridSetup::AlgebraicMultigridSetup (const tSparseSystem &system,
+                                                  std::vector<tProlongation> &prolongations,
+                                                  std::vector<tSparseSystem> &coarse) :
+        MultigridHierarchy(system, prolongations, coarse)
+{
+    //
+}
+
+
+////////////////////////////////////////////////////////////////
+
+
+MultigridPreconditioner::MultigridPreconditioner (const tSparseSystem &system,
+                                                  const MultigridHierarchy &hierarchy) :
+        system_(system), hierarchy_(hierarchy)
+{
+    //
+}
+
+
+void MultigridPreconditioner::apply (const DoubleVector &r, DoubleVector &z) const
+{
+    z.assign(r.size(), 0);
+    hierarchy_.cycle(system_, r, z, v_cycle);
+}
+
+
+////////////////////////////////////////////////////////////////
+
+
+// Hierarchy of system built from the given prolongations, taken from the cache
+// of the system if it was already built
+template <class Setup>
+static const MultigridHierarchy& getHierarchy (const tSparseSystem &system,
+                                               void (*build)(const tSparseSystem&,
+                                                             std::vector<tProlongation>&,
+                                                             std::vector<tSparseSystem>*))
+{
+    Setup *setup = findSetup<Setup>(system);
+
+    if (setup == nullptr)
+    {
+        std::vector<tProlongation> prolongations;
+        std::vector<tSparseSystem> coarse;
+        build(system, prolongations, &coarse);
+
+        setup = addSetup(system, new Setup(system, prolongations, coarse));
+    }
+
+    return *setup;
+}
+
+
+// Repeats multigrid cycles until the scaled residual is below tolerance
+static void multigridSolve (const tSparseSystem &system, DoubleVector &solution,
+                            double tolerance, bool verbose, CycleType type,
+                            const MultigridHierarchy &hierarchy)
+{
+    initialGuess(system, solution);
+
+    if (verbose)
+        std::cout << "Beggining multigrid (" << (type == v_cycle ? "V" : "F")
+                  << " cycle, " << hierarchy.getNumLevels() << " levels)"
+                  << std::endl;
+
+    DoubleVector r;
+    multiply(system, solution, r);
+
+    for (int i = 0; i < system.n_rows; i++)
+        r[i] = system.rhs[i] - r[i];
+
+    // the hierarchy is built by the caller
+    statsSetupDone();
+
+    double max_error = scaledResidual(system, r);
+    int n_iter = 0;
+
+    while (max_error > tolerance)
+    {
+        hierarchy.cycle(system, system.rhs, solution, type);
+
+        multiply(system, solution, r);
+
+        for (int i = 0; i < system.n_rows; i++)
+            r[i] = system.rhs[i] - r[i];
+
+        max_error = scaledResidual(system, r);
+        statsIteration(max_error);
+
+        if (verbose)
+            std::cout << " - Iteration " << n_iter <<" error: "
+                      << max_error << std::endl;
+
+        n_iter++;
+    }
+}
+
+
+void multigridV (const tSparseSystem &system, DoubleVector &solution,
+                 double tolerance, bool verbose)
+{
+    multigridSolve(system, solution, tolerance, verbose, v_cycle,
+                   getHierarchy<GeometricMultigridSetup>(system,
+                                                         buildGeometricProlongations));
+}
+
+
+void multigridF (const tSparseSystem &system, DoubleVector &solution,
+                 double tolerance, bool verbose)
+{
+    multigridSolve(system, solution, tolerance, verbose, f_cycle,
+                   getHierarchy<GeometricMultigridSetup>(system,
+                                                         buildGeometricProlongations));
+}
+
+
+void algebraicMultigrid (const tSparseSystem &system, DoubleVector &solution,
+                         double tolerance, bool verbose)
+{
+    multigridSolve(system, solution, tolerance, verbose, v_cycle,
+                   getHierarchy<AlgebraicMultigridSetup>(system,
+                                                         buildAggregationProlongations));
+}
+
+
+void conjugateGradientAMG (const tSparseSystem &system, DoubleVector &solution,
+                           double tolerance, bool verbose)
+{
+    const MultigridHierarchy &hierarchy =
+            getHierarchy<AlgebraicMultigridSetup>(system, buildAggregationProlongations);
+
+    conjugateGradient(system, solution, tolerance, verbose,
+                      MultigridPreconditioner(system, hierarchy));
+}
@@ -0,0 +1,260 @@
+#include "preconditioner.h"
+#include <algorithm>
+#include <math.h>
+#include <utility>
+#include "exceptions.h"
+#include "solve_stats.h"
+
+
+void Preconditioner::applyBlock (const DoubleVector &r, DoubleVector &z,
+                                 int n_rhs) const
+{
+    int n_nodes = r.size()/n_rhs;
+    DoubleVector r_column(n_nodes);
+    DoubleVector z_column;
+
+    z.resize(r.size());
+
+    for (int s = 0; s < n_rhs; s++)
+    {
+        for (int i = 0; i < n_nodes; i++)
+            r_column[i] = r[i*n_rhs + s];
+
+        apply(r_column, z_column);
+
+        for (int i = 0; i < n_nodes; i++)
+            z[i*n_rhs + s] = z_column[i];
+    }
+}
+
+
+////////////////////////////////////////////////////////////////
+
+
+JacobiPreconditioner::JacobiPreconditioner (const tSparseSystem &system) :
+        inv_diagonal_(system.n_rows)
+{
+    for (int i = 0; i < system.n_rows; i++)
+        inv_diagonal_[i] = 1/system.value[system.row_start[i]];
+}
+
+
+void JacobiPreconditioner::apply (const DoubleVector &r, DoubleVector &z) const
+{
+    z.resize(r.size());
+
+    for (int i = 0; i < r.size(); i++)
+        z[i] = r[i]*inv_diagonal_[i];
+
+    statsWork(r.size(), 24.0*r.size());
+}
+
+
+void JacobiPreconditioner::applyBlock (const DoubleVector &r, DoubleVector &z,
+                                       int n_rhs) const
+{
+    z.resize(r.size());
+
+    for (int i = 0; i < inv_diagonal_.size(); i++)
+        for (int s = 0; s < n_rhs; s++)
+            z[i*n_rhs + s] = r[i*n_rhs + s]*inv_diagonal_[i];
+}
+
+
+////////////////////////////////////////////////////////////////
+
+
+SSORPreconditioner::SSORPreconditioner (const tSparseSystem &system, double omega) :
+        system_(system), omega_(omega)
+{
+}
+
+
+void SSORPreconditioner::apply (const DoubleVector &r, DoubleVector &z) const
+{
+    int n_nodes = system_.n_rows;
+    z.resize(n_nodes);
+
+    // forward sweep (D/w + L) * y = r, y is stored in z
+    for (int i = 0; i < n_nodes; i++)
+    {
+        int diagonal = system_.row_start[i];
+        double value = r[i];
+
+        for (int k = diagonal+1; k < system_.row_start[i+1]; k++)
+            if (system_.col_index[k] < i)
+                value -= system_.value[k]*z[system_.col_index[k]];
+
+        z[i] = omega_*value/system_.value[diagonal];
+    }
+
+    // scale by (2-w)/w * D/w, the inverse of the two middle factors of M
+    for (int i = 0; i < n_nodes; i++)
+        z[i] *= (2-omega_)/(omega_*omega_)*system_.value[system_.row_start[i]];
+
+    // backward sweep (D/w + U) * z = y
+    for (int i = n_nodes-1; i >= 0; i--)
+    {
+        int diagonal = system_.row_start[i];
+        double value = z[i];
+
+        for (int k = diagonal+1; k < system_.row_start[i+1]; k++)
+            if (system_.col_index[k] > i)
+                value -= system_.value[k]*z[system_.col_index[k]];
+
+        z[i] = omega_*value/system_.value[diagonal];
+    }
+
+    // the coefficients of each row are read twice, half of them used each time
+    statsSweep(system_, 7, 52);
+}
+
+
+////////////////////////////////////////////////////////////////
+
+
+ICPreconditioner::ICPreconditioner (const tSparseSystem &system)
+{
+    int n_nodes = system.n_rows;
+
+    // copy the lower half of the system sorted by column with the diagonal last
+    row_start_.reserve(n_nodes+1);
+    row_start_.push_back(0);
+
+    for (int i = 0; i < n_nodes; i++)
+    {
+        std::vector<std::pair<int,double>> row;
+
+        for (int k = system.row_start[i]; k < system.row_start[i+1]; k++)
+            if (system.col_index[k] <= i)
+                row.push_back(std::make_pair(system.col_index[k], system.value[k]));
+
+        std::sort(row.begin(), row.end());
+
+        for (int k = 0; k < row.size(); k++)
+        {
+            col_index_.push_back(row[k].first);
+            value_.push_back(row[k].second);
+        }
+
+        row_start_.push_back(col_index_.size());
+    }
+
+    // row by row factorization, only the positions of the system are filled
+    for (int i = 0; i < n_nodes; i++)
+    {
+        int diagonal = row_start_[i+1]-1;
+
+        for (int q = row_start_[i]; q < diagonal; q++)
+        {
+            int k = col_index_[q];
+            double value = value_[q];
+
+            // subtract L_ij*L_kj for the columns j < k present in both rows
+            int p_i = row_start_[i];
+            int p_k = row_start_[k];
+
+            while (p_i < q and p_k < row_start_[k+1]-1)
+            {
+                if (col_index_[p_i] == col_index_[p_k])
+                    value -= value_[p_i++]*value_[p_k++];
+                else if (col_index_[p_i] < col_index_[p_k])
+                    p_i++;
+                else
+                    p_k++;
+            }
+
+            value_[q] = value/value_[row_start_[k+1]-1];
+        }
+
+        double pivot = value_[diagonal];
+
+        for (int q = row_start_[i]; q < diagonal; q++)
+            pivot -= value_[q]*value_[q];
+
+        if (not (pivot > 0))
+            throw NotPositiveDefinite();
+
+        value_[diagonal] = sqrt(pivot);
+    }
+}
+
+
+void ICPreconditioner::apply (const DoubleVector &r, DoubleVector &z) const
+{
+    int n_nodes = row_start_.size()-1;
+    z.resize(n_nodes);
+
+    // forward substitution L * y = r, y is stored in z
+    for (int i = 0; i < n_nodes; i++)
+    {
+        int diagonal = row_start_[i+1]-1;
+        double value = r[i];
+
+        for (int q = row_start_[i]; q < diagonal; q++)
+            value -= value_[q]*z[col_index_[q]];
+
+        z[i] = value/value_[diagonal];
+    }
+
+    // backward substitution L^T * z = y going through L by rows
+    for (int i = n_nodes-1; i >= 0; i--)
+    {
+        int diagonal = row_start_[i+1]-1;
+
+        z[i] /= value_[diagonal];
+
+        for (int q = row_start_[i]; q < diagonal; q++)
+            z[col_index_[q]] -= value_[q]*z[i];
+    }
+
+    // L read twice, r read and z written and read back
+    statsWork(4.0*value_.size(), 24.0*value_.size() + 40.0*n_nodes);
+}
+
+
+void ICPreconditioner::applyBlock (const DoubleVector &r, DoubleVector &z,
+                                   int n_rhs) const
+{
+    int n_nodes = row_start_.size()-1;
+    z.resize(r.size());
+
+    // same substitutions as apply, each coefficient of L is read once for all
+    // the vectors
+    for (int i = 0; i < n_nodes; i++)
+    {
+        int diagonal = row_start_[i+1]-1;
+        double *z_i = &z[i*n_rhs];
+
+        for (int s = 0; s < n_rhs; s++)
+            z_i[s] = r[i*n_rhs + s];
+
+        for (int q = row_start_[i]; q < diagonal; q++)
+        {
+            const double *z_j = &z[col_index_[q]*n_rhs];
+
+            for (int s = 0; s < n_rhs; s++)
+                z_i[s] -= value_[q]*z_j[s];
+        }
+
+        for (int s = 0; s < n_rhs; s++)
+            z_i[s] /= value_[diagonal];
+    }
+
+    for (int i = n_nodes-1; i >= 0; i--)
+    {
+        int diagonal = row_start_[i+1]-1;
+        double *z_i = &z[i*n_rhs];
+
+        for (int s = 0; s < n_rhs; s++)
+            z_i[s] /= value_[diagonal];
+
+        for (int q = row_start_[i]; q < diagonal; q++)
+        {
+            double *z_j = &z[col_index_[q]*n_rhs];
+
+            for (int s = 0; s < n_rhs; s++)
+                z_j[s] -= value_[q]*z_i[s];
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include "solve_stats.h"
+#include <chrono>
+
+
+thread_local tSolveStats *active_solve_stats = nullptr;
+thread_local double solve_stats_start = 0;
+thread_local double solve_stats_setup_end = -1;
+
+
+double statsClock ()
+{
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void resetSolveStats (tSolveStats &stats)
+{
+    stats.iterations = 0;
+    stats.residuals.clear();
+    stats.assembly_time = 0;
+    stats.setup_time = 0;
+    stats.solve_time = 0;
+    stats.flops = 0;
+    stats.bytes = 0;
+}
+
+
+SolveStatsScope::SolveStatsScope (tSolveStats *stats) :
+        previous_(active_solve_stats), previous_start_(solve_stats_start),
+        previous_setup_end_(solve_stats_setup_end)
+{
+    active_solve_stats = stats;
+    solve_stats_start = (stats ? statsClock() : 0);
+    solve_stats_setup_end = -1;
+}
+
+
+void statsSetupDone ()
+{
+    if (active_solve_stats and solve_stats_setup_end < 0)
+        solve_stats_setup_end = statsClock();
+}
+
+
+SolveStatsScope::~SolveStatsScope ()
+{
+    tSolveStats *stats = active_solve_stats;
+
+    if (stats)
+    {
+        double end = statsClock();
+
+        // solvers without setups may not say when they finish them
+        double setup_end = (solve_stats_setup_end < 0 ? solve_stats_start :
+                                                        solve_stats_setup_end);
+
+        stats->setup_time += setup_end - solve_stats_start;
+        stats->solve_time += end - setup_end;
+    }
+
+    active_solve_stats = previous_;
+    solve_stats_start = previous_start_;
+    solve_stats_setup_end = previous_setup_end_;
+}
@@ -1,55 +1,909 @@
+#include <cstdlib>
 #include <iostream>
+#include <math.h>
+#include <set>
 #include "solver.h"
+#include "exceptions.h"
+#include "solve_stats.h"
+#include "thread_pool.h"
 
+// nodes updated by each task of multicolorGaussSeidel
+#define MULTICOLOR_CHUNK 1024
+// the convergence ratio of SOR is taken as stable when it changes less than
+// the stability fraction during several sweeps in a row
+#define SOR_ESTIMATION_STABILITY 1e-3
+#define SOR_STABLE_SWEEPS 5
+#define SOR_RELIABILITY_EXPONENT 0.75
+#define SOR_MAX_MU 0.99999
+// SSOR measures its convergence ratio with this many iterations for each of
+// the relaxation factors tried, between 1 and SSOR_MAX_OMEGA
+#define SSOR_PROBE_ITERATIONS 20
+#define SSOR_PROBE_FACTORS 10
+#define SSOR_MAX_OMEGA 1.99
 
-void gaussSeidel (const DoubleMatrix &system, DoubleVector &solution,
+
+// Lines of nodes of a structured mesh that are coupled along one direction,
+// that is, nodes whose indices differ by stride
+typedef struct _tLineSet
+{
+    int stride;
+
+    // the nodes of line l are node[line_start[l]] ... node[line_start[l+1]-1]
+    std::vector<int> line_start;
+    std::vector<int> node;
+
+    // lines are sorted by color and the ones of color c are the lines
+    // color_start[c] ... color_start[c+1]-1. Lines of the same color do not
+    // share coefficients, so they can be solved at the same time
+    std::vector<int> color_start;
+
+    // coefficients of the TDMA forward elimination of each line, which do not
+    // change between iterations (same positions as node)
+    DoubleVector lower;     // a_i
+    DoubleVector inv_pivot; // 1/(b_i - a_i*upper_(i-1))
+    DoubleVector upper;     // c_i*inv_pivot_i
+} tLineSet;
+
+
+// Colors the vertices of a graph so that neighbors never share color, going
+// through them in order and giving each one the lowest color its neighbors
+// do not have. The neighbors of vertex v are neighbor[start[v]] ...
+// neighbor[start[v+1]-1]. The graph is made symmetric first, so a link given
+// only in one direction (a_ij stored but not a_ji) also separates both
+// vertices. Returns the number of colors used
+static int greedyColoring (int n_vertices, const std::vector<int> &start,
+                           const std::vector<int> &neighbor,
+                           std::vector<int> &color)
+{
+    // each link in both directions, the repeated ones do no harm
+    std::vector<int> both_start(n_vertices+1, 0);
+
+    for (int v = 0; v < n_vertices; v++)
+        for (int k = start[v]; k < start[v+1]; k++)
+            if (neighbor[k] != v)
+            {
+                both_start[v+1]++;
+                both_start[neighbor[k]+1]++;
+            }
+
+    for (int v = 0; v < n_vertices; v++)
+        both_start[v+1] += both_start[v];
+
+    std::vector<int> both(both_start.back());
+    std::vector<int> next(both_start.begin(), both_start.end()-1);
+
+    for (int v = 0; v < n_vertices; v++)
+        for (int k = start[v]; k < start[v+1]; k++)
+            if (neighbor[k] != v)
+            {
+                both[next[v]++] = neighbor[k];
+                both[next[neighbor[k]]++] = v;
+            }
+
+    color.assign(n_vertices, -1);
+    std::vector<int> color_used_by(n_vertices+1, -1);
+    int n_colors = 0;
+
+    for (int v = 0; v < n_vertices; v++)
+    {
+        for (int k = both_start[v]; k < both_start[v+1]; k++)
+            if (color[both[k]] >= 0)
+                color_used_by[color[both[k]]] = v;
+
+        int c = 0;
+
+        while (color_used_by[c] == v)
+            c++;
+
+        color[v] = c;
+
+        if (c+1 > n_colors)
+            n_colors = c+1;
+    }
+
+    return n_colors;
+}
+
+
+// Precomputes the forward elimination of the TDMA of every line
+static void factorLines (const tSparseSystem &system, tLineSet &lines)
+{
+    lines.lower.assign(lines.node.size(), 0);
+    lines.inv_pivot.assign(lines.node.size(), 0);
+    lines.upper.assign(lines.node.size(), 0);
+
+    for (int l = 0; l+1 < lines.line_start.size(); l++)
+    {
+        int first = lines.line_start[l];
+        int last = lines.line_start[l+1]-1;
+
+        for (int p = first; p <= last; p++)
+        {
+            int i = lines.node[p];
+            double diagonal = 0;
+            double upper = 0;
+
+            for (int k = system.row_start[i]; k < system.row_start[i+1]; k++)
+            {
+                int j = system.col_index[k];
+
+                if (j == i)
+                    diagonal += system.value[k];
+                else if (p > first and j == i-lines.stride)
+                    lines.lower[p] += system.value[k];
+                else if (p < last and j == i+lines.stride)
+                    upper += system.value[k];
+            }
+
+            double previous_upper = (p == first ? 0 : lines.upper[p-1]);
+
+            lines.inv_pivot[p] = 1/(diagonal - lines.lower[p]*previous_upper);
+            lines.upper[p] = upper*lines.inv_pivot[p];
+        }
+    }
+}
+
+
+// Splits the nodes into lines along each one of the index offsets present in
+// the system (1, nx and nx*ny for a structured mesh numbered in order)
+static void findLines (const tSparseSystem &system,
+                       std::vector<tLineSet> &directions)
+{
+    int n_nodes = system.n_rows;
+    std::set<int> strides;
+
+    for (int i = 0; i < n_nodes; i++)
+        for (int k = system.row_start[i]+1; k < system.row_start[i+1]; k++)
+            strides.insert(std::abs(system.col_index[k] - i));
+
+    if (strides.size() > 3)
+        throw NotStructuredSystem();
+
+    directions.clear();
+
+    for (std::set<int>::iterator it = strides.begin(); it != strides.end(); it++)
+    {
+        int stride = *it;
+
+        // two nodes are linked if any of them has a coefficient for the other
+        std::vector<char> has_next(n_nodes, 0);
+        std::vector<char> has_previous(n_nodes, 0);
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            for (int k = system.row_start[i]+1; k < system.row_start[i+1]; k++)
+            {
+                int j = system.col_index[k];
+
+                if (j - i == stride)
+                    has_next[i] = has_previous[j] = 1;
+                else if (i - j == stride)
+                    has_next[j] = has_previous[i] = 1;
+            }
+        }
+
+        // walk each line from its first node
+        std::vector<int> line_start(1, 0);
+        std::vector<int> line_node;
+        std::vector<int> line_of_node(n_nodes);
+        line_node.reserve(n_nodes);
+
+        for (int i = 0; i < n_nodes; i++)
+        {
+            if (has_previous[i])
+                continue;
+
+            int current = i;
+            line_node.push_back(current);
+            line_of_node[current] = line_start.size()-1;
+
+            while (has_next[current])
+            {
+                current += stride;
+                line_node.push_back(current);
+                line_of_node[current] = line_start.size()-1;
+            }
+
+            line_start.push_back(line_node.size());
+        }
+
+        int n_lines = line_start.size()-1;
+
+        // two lines are neighbors if any of their nodes share a coefficient
+        // (for structured meshes two colors suffice)
+        std::vector<int> neighbor_start(1, 0);
+        std::vector<int> neighbor;
+
+        for (int l = 0; l < n_lines; l++)
+        {
+            for (int p = line_start[l]; p < line_start[l+1]; p++)
+            {
+                int i = line_node[p];
+
+                for (int k = system.row_start[i]+1; k < system.row_start[i+1]; k++)
+                    neighbor.push_back(line_of_node[system.col_index[k]]);
+            }
+
+            neighbor_start.push_back(neighbor.size());
+        }
+
+        std::vector<int> line_color;
+        int n_colors = greedyColoring(n_lines, neighbor_start, neighbor,
+                                      line_color);
+
+        // store the lines sorted by color
+        tLineSet lines;
+        lines.stride = stride;
+        lines.line_start.push_back(0);
+        lines.node.reserve(n_nodes);
+        lines.color_start.push_back(0);
+
+        for (int color = 0; color < n_colors; color++)
+        {
+            for (int l = 0; l < n_lines; l++)
+            {
+                if (line_color[l] != color)
+                    continue;
+
+                for (int p = line_start[l]; p < line_start[l+1]; p++)
+                    lines.node.push_back(line_node[p]);
+
+                lines.line_start.push_back(lines.node.size());
+            }
+
+            lines.color_start.push_back(lines.line_start.size()-1);
+        }
+
+        factorLines(system, lines);
+        directions.push_back(lines);
+    }
+}
+
+
+// Solves the nodes of one line with TDMA taking the rest of the nodes as known
+// values and returns the biggest change in the solution. d is a scratch array
+// at least as long as the line
+static double solveLine (const tSparseSystem &system, const tLineSet &lines,
+                         int line, DoubleVector &solution, double *d)
+{
+    int first = lines.line_start[line];
+    int length = lines.line_start[line+1] - first;
+
+    // forward elimination of the independent terms, where the coefficients
+    // of the nodes outside the line are moved to the right hand side
+    for (int p = 0; p < length; p++)
+    {
+        int i = lines.node[first+p];
+        double value = system.rhs[i];
+
+        for (int k = system.row_start[i]+1; k < system.row_start[i+1]; k++)
+        {
+            int j = system.col_index[k];
+
+            if ((p > 0 and j == i-lines.stride) or
+                (p < length-1 and j == i+lines.stride))
+                continue;
+
+            value -= system.value[k]*solution[j];
+        }
+
+        double previous_d = (p == 0 ? 0 : d[p-1]);
+        d[p] = (value - lines.lower[first+p]*previous_d)*lines.inv_pivot[first+p];
+    }
+
+    // back substitution
+    for (int p = length-2; p >= 0; p--)
+        d[p] -= lines.upper[first+p]*d[p+1];
+
+    double max_error = 0;
+
+    for (int p = 0; p < length; p++)
+    {
+        int i = lines.node[first+p];
+        double current_error = d[p] - solution[i];
+
+        if (current_error < 0)
+            current_error *= -1;
+
+        if (current_error > max_error)
+            max_error = current_error;
+
+        solution[i] = d[p];
+    }
+
+    return max_error;
+}
+
+
+double relaxationSweep (const tSparseSystem &system, const DoubleVector &rhs,
+                        DoubleVector &solution, double omega, bool backward)
+{
+    int n_nodes = system.n_rows;
+    double max_error = 0;
+
+    for (int n = 0; n < n_nodes; n++)
+    {
+        int i = (backward ? n_nodes-1-n : n);
+        int diagonal = system.row_start[i];
+        double value = rhs[i];
+
+        // the diagonal is stored first, only the neighbors are visited
+        for (int k = diagonal+1; k < system.row_start[i+1]; k++)
+            value -= system.value[k]*solution[system.col_index[k]];
+        
+        value = (1-omega)*solution[i] + omega*value/system.value[diagonal];
+
+        double current_error = value - solution[i];
+
+        if (current_error < 0)
+            current_error *= -1;
+
+        if (current_error > max_error)
+            max_error = current_error;
+                    
+        solution[i] = value;
+    }
+
+    // rhs read, solution read and written
+    statsSweep(system, (omega == 1 ? 2 : 5), 24);
+
+    return max_error;
+}
+
+
+double gaussSeidelSweep (const tSparseSystem &system, const DoubleVector &rhs,
+                         DoubleVector &solution, bool backward)
+{
+    return relaxationSweep(system, rhs, solution, 1, backward);
+}
+
+
+void gaussSeidel (const tSparseSystem &system, DoubleVector &solution,
                  double tolerance, bool verbose)
 {
-    int n_nodes = system.size();
-    solution = DoubleVector(n_nodes, 0);
+    initialGuess(system, solution);
     double max_error = tolerance+1;
 
     if (verbose)
         std::cout << "Beggining Gauss-Seidel" << std::endl;
     
+    statsSetupDone();
+    int n_iter = 0;
+
+    while (max_error > tolerance)
+    {
+        max_error = gaussSeidelSweep(system, system.rhs, solution);
+        statsIteration(max_error);
+
+        if (verbose)
+            std::cout << " - Iteration " << n_iter <<" error: "
+                      << max_error << std::endl;
+    
+        n_iter++;
+    }
+}
+
+
+// Nodes of a system grouped by color, such that nodes of the same color do not
+// share coefficients. For structured meshes numbered in order the greedy
+// coloring gives the red-black (checkerboard) one
+class ColoringSetup : public SolverSetup
+{
+public:
+
+    ColoringSetup (const tSparseSystem &system)
+    {
+        std::vector<int> color;
+        int n_colors = greedyColoring(system.n_rows, system.row_start,
+                                      system.col_index, color);
+
+        color_start.assign(n_colors+1, 0);
+
+        for (int i = 0; i < system.n_rows; i++)
+            color_start[color[i]+1]++;
+
+        for (int c = 0; c < n_colors; c++)
+            color_start[c+1] += color_start[c];
+
+        std::vector<int> next(color_start.begin(), color_start.end()-1);
+        node.resize(system.n_rows);
+
+        for (int i = 0; i < system.n_rows; i++)
+            node[next[color[i]]++] = i;
+    }
+
+    bool structural () const override { return true; }
+
+    // nodes of color c are node[color_start[c]] ... node[color_start[c+1]-1]
+    std::vector<int> color_start;
+    std::vector<int> node;
+};
+
+
+void multicolorGaussSeidel (const tSparseSystem &system, DoubleVector &solution,
+                            double tolerance, bool verbose)
+{
+    int n_nodes = system.n_rows;
+    initialGuess(system, solution);
+    double max_error = tolerance+1;
+
+    const ColoringSetup *coloring = findSetup<ColoringSetup>(system);
+
+    if (coloring == nullptr)
+        coloring = addSetup(system, new ColoringSetup(system));
+
+    int n_colors = coloring->color_start.size()-1;
+
+    if (verbose)
+        std::cout << "Beggining multicolor Gauss-Seidel (" << n_colors
+                  << " colors)" << std::endl;
+
+    ThreadPool &pool = defaultThreadPool();
+    DoubleVector chunk_error(n_nodes/MULTICOLOR_CHUNK + n_colors);
+    statsSetupDone();
     int n_iter = 0;
 
     while (max_error > tolerance)
     {
+        chunk_error.assign(chunk_error.size(), 0);
+
+        // nodes of one color only depend on nodes of other colors
+        for (int c = 0; c < n_colors; c++)
+        {
+            int first = coloring->color_start[c];
+            int n_color_nodes = coloring->color_start[c+1] - first;
+
+            pool.parallelFor(n_color_nodes, MULTICOLOR_CHUNK,
+                             [&] (int begin, int end)
+            {
+                double &error = chunk_error[(first+begin)/MULTICOLOR_CHUNK + c];
+
+                for (int p = first+begin; p < first+end; p++)
+                {
+                    int i = coloring->node[p];
+                    int diagonal = system.row_start[i];
+                    double value = system.rhs[i];
+
+                    for (int k = diagonal+1; k < system.row_start[i+1]; k++)
+                        value -= system.value[k]*solution[system.col_index[k]];
+
+                    value = value/system.value[diagonal];
+
+                    double current_error = value - solution[i];
+
+                    if (current_error < 0)
+                        current_error *= -1;
+
+                    if (current_error > error)
+                        error = current_error;
+
+                    solution[i] = value;
+                }
+            });
+        }
+
         max_error = 0;
 
-        for (int i = 0; i < n_nodes; i++)
+        for (int k = 0; k < chunk_error.size(); k++)
+            if (chunk_error[k] > max_error)
+                max_error = chunk_error[k];
+
+        // as gaussSeidelSweep, plus the node of each position
+        statsSweep(system, 2, 28);
+        statsIteration(max_error);
+
+        if (verbose)
+            std::cout << " - Iteration " << n_iter <<" error: "
+                      << max_error << std::endl;
+
+        n_iter++;
+    }
+}
+
+
+// Sweep of SOR (both directions if symmetric = true) returning the biggest
+// change of the solution and storing in change_norm its euclidean norm
+static double overRelaxationSweep (const tSparseSystem &system,
+                                   DoubleVector &solution, DoubleVector &previous,
+                                   double omega, bool symmetric,
+                                   double &change_norm)
+{
+    previous = solution;
+
+    double max_error = relaxationSweep(system, system.rhs, solution, omega);
+
+    if (symmetric)
+    {
+        double backward_error = relaxationSweep(system, system.rhs, solution,
+                                                omega, true);
+
+        if (backward_error > max_error)
+            max_error = backward_error;
+    }
+
+    change_norm = 0;
+
+    for (int i = 0; i < solution.size(); i++)
+        change_norm += (solution[i]-previous[i])*(solution[i]-previous[i]);
+
+    change_norm = sqrt(change_norm);
+
+    // copy to previous and norm of the change
+    statsWork(3.0*solution.size(), 32.0*solution.size());
+
+    return max_error;
+}
+
+
+// Convergence ratio of SSOR with relaxation factor omega: the norm of the
+// error of A*x = 0 starting from x = 1 is divided by its previous value after
+// SSOR_PROBE_ITERATIONS iterations, when the slowest modes dominate
+static double ssorConvergenceRatio (const tSparseSystem &system, double omega)
+{
+    DoubleVector zero(system.n_rows, 0);
+    DoubleVector error(system.n_rows, 1);
+    DoubleVector previous;
+    double change_norm;
+    double previous_norm = sqrt(system.n_rows);
+    double ratio = 0;
+
+    for (int i = 0; i < SSOR_PROBE_ITERATIONS; i++)
+    {
+        previous = error;
+        relaxationSweep(system, zero, error, omega);
+        relaxationSweep(system, zero, error, omega, true);
+
+        change_norm = 0;
+
+        for (int j = 0; j < error.size(); j++)
+            change_norm += error[j]*error[j];
+
+        change_norm = sqrt(change_norm);
+        ratio = change_norm/previous_norm;
+        previous_norm = change_norm;
+    }
+
+    return ratio;
+}
+
+
+// Relaxation factor of SSOR with the smallest convergence ratio, found with a
+// golden section search. The formula of the optimal factor for SSOR depends on
+// the spectral radius of D^-1*L*D^-1*U, which is not known and changes the
+// result a lot, but the eigenvalues of SSOR for a symmetric system are real and
+// positive, so the ratio can be measured reliably with a few iterations
+static double estimateSSORFactor (const tSparseSystem &system)
+{
+    const double golden = (sqrt(5.0) - 1)/2;
+
+    double low = 1;
+    double high = SSOR_MAX_OMEGA;
+    double left = high - golden*(high - low);
+    double right = low + golden*(high - low);
+    double left_ratio = ssorConvergenceRatio(system, left);
+    double right_ratio = ssorConvergenceRatio(system, right);
+
+    for (int i = 2; i < SSOR_PROBE_FACTORS; i++)
+    {
+        if (left_ratio <= right_ratio)
+        {
+            high = right;
+            right = left;
+            right_ratio = left_ratio;
+            left = high - golden*(high - low);
+            left_ratio = ssorConvergenceRatio(system, left);
+        }
+        else
         {
-            double value = system[i][n_nodes];
+            low = left;
+            left = right;
+            left_ratio = right_ratio;
+            right = low + golden*(high - low);
+            right_ratio = ssorConvergenceRatio(system, right);
+        }
+    }
+
+    return (left_ratio <= right_ratio ? left : right);
+}
+
 
-            for (int j = 0; j < n_nodes; j++)
-                if (i != j)
-                    value -= system[i][j]*solution[j];
-            
-            value = value/system[i][i];
+// The relaxation factor of SSOR estimated for some coefficients, kept in the
+// cache of the system so that the search is done only once for them
+class SSORFactorSetup : public SolverSetup
+{
+public:
 
-            double current_error = value - solution[i];
+    SSORFactorSetup (const tSparseSystem &system) :
+            omega(estimateSSORFactor(system)) {}
 
-            if (current_error < 0)
-                current_error *= -1;
+    double omega;
+};
+
+
+// Successive over-relaxation, one forward sweep per iteration or a forward and
+// a backward one if symmetric = true. omega <= 0 means it must be estimated.
+// SOR does it while iterating (adaptive procedure of Hageman and Young):
+// starting from Gauss-Seidel (w = 1), the ratio between the norms of the
+// changes of consecutive sweeps approaches the spectral radius of the current
+// iteration (lambda). Once it is stable, and as long as it is below 1 and above
+// (w-1)^0.75 (when w goes past the optimum lambda falls to w-1 and the
+// estimate is no longer reliable), the spectral radius of Jacobi is estimated
+// as  mu = (lambda + w - 1)/(w*sqrt(lambda))  and if it grew the relaxation
+// factor is raised to w = 2/(1 + sqrt(1 - mu^2)). SSOR estimates it before
+// starting (see estimateSSORFactor) and keeps it in the cache of the system
+static void overRelaxation (const tSparseSystem &system, DoubleVector &solution,
+                            double tolerance, bool verbose, double omega,
+                            bool symmetric)
+{
+    initialGuess(system, solution);
+
+    if (verbose)
+        std::cout << "Beggining " << (symmetric ? "SSOR" : "SOR") << std::endl;
 
-            if (current_error > max_error)
-                max_error = current_error;
-                        
-            solution[i] = value;
+    if (symmetric and omega <= 0)
+    {
+        const SSORFactorSetup *setup = findSetup<SSORFactorSetup>(system);
+
+        if (setup == nullptr)
+            setup = addSetup(system, new SSORFactorSetup(system));
+
+        omega = setup->omega;
+
+        if (verbose)
+            std::cout << " - Relaxation factor: " << omega << std::endl;
+    }
+
+    bool estimating = (omega <= 0);
+    double mu = 0;
+    double change_norm = 0;
+    double previous_norm = 0;
+    double previous_ratio = 0;
+    int n_stable = 0;
+    DoubleVector previous;
+
+    if (estimating)
+        omega = 1;
+
+    statsSetupDone();
+    double max_error = tolerance+1;
+    int n_iter = 0;
+
+    while (max_error > tolerance)
+    {
+        max_error = overRelaxationSweep(system, solution, previous, omega,
+                                        symmetric, change_norm);
+        statsIteration(max_error);
+
+        if (estimating and n_iter > 0)
+        {
+            double ratio = change_norm/previous_norm;
+
+            if (std::abs(ratio - previous_ratio) < SOR_ESTIMATION_STABILITY*ratio)
+                n_stable++;
+            else
+                n_stable = 0;
+
+            previous_ratio = ratio;
+
+            if (n_stable >= SOR_STABLE_SWEEPS and ratio < 1 and
+                ratio >= pow(omega - 1, SOR_RELIABILITY_EXPONENT))
+            {
+                double new_mu = (ratio + omega - 1)/(omega*sqrt(ratio));
+
+                if (new_mu > SOR_MAX_MU)
+                    new_mu = SOR_MAX_MU;
+
+                if (new_mu > mu)
+                {
+                    mu = new_mu;
+                    omega = 2/(1 + sqrt(1 - mu*mu));
+
+                    if (verbose)
+                        std::cout << " - Relaxation factor: " << omega << std::endl;
+                }
+
+                n_stable = 0;
+            }
         }
 
+        previous_norm = change_norm;
+
         if (verbose)
             std::cout << " - Iteration " << n_iter <<" error: "
                       << max_error << std::endl;
-    
+
         n_iter++;
     }
 }
 
 
-void TDMA (const DoubleMatrix &system, DoubleVector &solution,
+void SOR (const tSparseSystem &system, DoubleVector &solution,
+          double tolerance, bool verbose, double omega)
+{
+    if (omega <= 0 or omega >= 2)
+        throw BadRelaxationFactor();
+
+    overRelaxation(system, solution, tolerance, verbose, omega, false);
+}
+
+
+void SOR (const tSparseSystem &system, DoubleVector &solution,
+          double tolerance, bool verbose)
+{
+    overRelaxation(system, solution, tolerance, verbose, 0, false);
+}
+
+
+void SSOR (const tSparseSystem &system, DoubleVector &solution,
+           double tolerance, bool verbose, double omega)
+{
+    if (omega <= 0 or omega >= 2)
+        throw BadRelaxationFactor();
+
+    overRelaxation(system, solution, tolerance, verbose, omega, true);
+}
+
+
+void SSOR (const tSparseSystem &system, DoubleVector &solution,
+           double tolerance, bool verbose)
+{
+    overRelaxation(system, solution, tolerance, verbose, 0, true);
+}
+
+
+// The whole system as a single line, factored once and kept in the cache of
+// the system
+class TridiagonalSetup : public SolverSetup
+{
+public:
+
+    TridiagonalSetup (const tSparseSystem &system)
+    {
+        int n_nodes = system.n_rows;
+
+        // the equation of each node is  a_i*x_(i-1) + b_i*x_i + c_i*x_(i+1) = d_i
+        for (int i = 0; i < n_nodes; i++)
+            for (int k = system.row_start[i]; k < system.row_start[i+1]; k++)
+                if (std::abs(system.col_index[k] - i) > 1)
+                    throw NotTridiagonalSystem();
+
+        line.stride = 1;
+        line.line_start.push_back(0);
+        line.line_start.push_back(n_nodes);
+        line.color_start.push_back(0);
+        line.color_start.push_back(1);
+
+        for (int i = 0; i < n_nodes; i++)
+            line.node.push_back(i);
+
+        factorLines(system, line);
+    }
+
+    tLineSet line;
+};
+
+
+void TDMA (const tSparseSystem &system, DoubleVector &solution,
            double void_parameter, bool verbose)
 {
-    throw "NOT IMPLEMENTED";
-}
\ No newline at end of file
+    int n_nodes = system.n_rows;
+
+    if (verbose)
+        std::cout << "Beggining TDMA" << std::endl;
+
+    const TridiagonalSetup *setup = findSetup<TridiagonalSetup>(system);
+
+    if (setup == nullptr)
+        setup = addSetup(system, new TridiagonalSetup(system));
+
+    statsSetupDone();
+
+    // every coefficient belongs to the line, so the previous values of the
+    // solution are not used
+    solution.assign(n_nodes, 0);
+    DoubleVector d(n_nodes);
+    solveLine(system, setup->line, 0, solution, &d[0]);
+
+    // elimination and substitution with the three factors of each node
+    statsSweep(system, 5, 52);
+
+    if (verbose)
+        std::cout << " - Solved " << n_nodes << " nodes" << std::endl;
+}
+
+
+// Lines of every direction of a structured mesh with their factorizations
+class LineSetup : public SolverSetup
+{
+public:
+
+    LineSetup (const tSparseSystem &system) : max_length(0)
+    {
+        findLines(system, directions);
+
+        for (int dir = 0; dir < directions.size(); dir++)
+        {
+            const tLineSet &lines = directions[dir];
+
+            for (int l = 0; l+1 < lines.line_start.size(); l++)
+            {
+                int length = lines.line_start[l+1] - lines.line_start[l];
+
+                if (length > max_length)
+                    max_length = length;
+            }
+        }
+    }
+
+    std::vector<tLineSet> directions;
+    int max_length;
+};
+
+
+void lineByLineTDMA (const tSparseSystem &system, DoubleVector &solution,
+                     double tolerance, bool verbose)
+{
+    initialGuess(system, solution);
+
+    if (verbose)
+        std::cout << "Beggining line by line TDMA" << std::endl;
+
+    const LineSetup *setup = findSetup<LineSetup>(system);
+
+    if (setup == nullptr)
+        setup = addSetup(system, new LineSetup(system));
+
+    const std::vector<tLineSet> &directions = setup->directions;
+    int max_length = setup->max_length;
+
+    ThreadPool &pool = defaultThreadPool();
+    // give each chunk of lines a few thousand nodes to amortize the scheduling
+    int chunk_lines = 4096/(max_length > 0 ? max_length : 1) + 1;
+
+    statsSetupDone();
+    double max_error = tolerance+1;
+    int n_iter = 0;
+
+    while (max_error > tolerance)
+    {
+        max_error = 0;
+
+        // alternate the direction of the lines, all the lines of a direction
+        // that share color are independent and are solved in parallel
+        for (int dir = 0; dir < directions.size(); dir++)
+        {
+            const tLineSet &lines = directions[dir];
+            DoubleVector line_error(lines.line_start.size()-1, 0);
+
+            for (int color = 0; color+1 < lines.color_start.size(); color++)
+            {
+                int first_line = lines.color_start[color];
+                int n_lines = lines.color_start[color+1] - first_line;
+
+                pool.parallelFor(n_lines, chunk_lines, [&] (int begin, int end)
+                {
+                    DoubleVector d(max_length);
+
+                    for (int l = first_line+begin; l < first_line+end; l++)
+                        line_error[l] = solveLine(system, lines, l, solution,
+                                                  &d[0]);
+                });
+            }
+
+            for (int l = 0; l < line_error.size(); l++)
+                if (line_error[l] > max_error)
+                    max_error = line_error[l];
+
+            // as in TDMA
+            statsSweep(system, 5, 52);
+        }
+
+        statsIteration(max_error);
+
+        if (verbose)
+            std::cout << " - Iteration " << n_iter <<" error: "
+                      << max_error << std::endl;
+
+        n_iter++;
+    }
+}
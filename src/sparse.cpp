@@ -0,0 +1,115 @@
+#include "sparse.h"
+#include "solve_stats.h"
+
+
+void initSparseSystem (tSparseSystem &system, int n_rows, int nnz_estimate)
+{
+    system.n_rows = n_rows;
+
+    system.row_start.clear();
+    system.row_start.reserve(n_rows+1);
+    system.row_start.push_back(0);
+
+    system.col_index.clear();
+    system.col_index.reserve(nnz_estimate);
+
+    system.value.clear();
+    system.value.reserve(nnz_estimate);
+
+    system.rhs.assign(n_rows, 0);
+
+    clearSetups(system);
+}
+
+
+void initialGuess (const tSparseSystem &system, DoubleVector &solution)
+{
+    if (solution.size() != system.n_rows)
+        solution.assign(system.n_rows, 0);
+}
+
+
+void clearSetups (const tSparseSystem &system, bool keep_structural)
+{
+    std::vector<std::shared_ptr<SolverSetup>> &setups = system.cache.setups;
+
+    if (not keep_structural)
+    {
+        setups.clear();
+        return;
+    }
+
+    int kept = 0;
+
+    for (int i = 0; i < setups.size(); i++)
+        if (setups[i]->structural())
+            setups[kept++] = setups[i];
+
+    setups.resize(kept);
+}
+
+
+void addCoefficient (tSparseSystem &system, int column, double value)
+{
+    int nnz = system.col_index.size();
+
+    // rows only have a handful of coefficients, so a linear search is enough
+    for (int k = system.row_start.back(); k < nnz; k++)
+    {
+        if (system.col_index[k] == column)
+        {
+            system.value[k] += value;
+            return;
+        }
+    }
+
+    system.col_index.push_back(column);
+    system.value.push_back(value);
+}
+
+
+void closeRow (tSparseSystem &system)
+{
+    system.row_start.push_back(system.col_index.size());
+}
+
+
+void multiply (const tSparseSystem &system, const DoubleVector &x,
+               DoubleVector &result)
+{
+    result.resize(system.n_rows);
+
+    for (int i = 0; i < system.n_rows; i++)
+    {
+        double value = 0;
+
+        for (int k = system.row_start[i]; k < system.row_start[i+1]; k++)
+            value += system.value[k]*x[system.col_index[k]];
+
+        result[i] = value;
+    }
+
+    // x read and result written
+    statsSweep(system, 0, 16);
+}
+
+
+double scaledResidual (const tSparseSystem &system, const DoubleVector &r)
+{
+    double max_error = 0;
+
+    for (int i = 0; i < system.n_rows; i++)
+    {
+        double current_error = r[i]/system.value[system.row_start[i]];
+
+        if (current_error < 0)
+            current_error *= -1;
+
+        if (current_error > max_error)
+            max_error = current_error;
+    }
+
+    statsWork(2.0*system.n_rows, 20.0*system.n_rows);
+
+    return max_error;
+}
@@ -0,0 +1,91 @@
+#include "sweep.h"
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include "thread_pool.h"
+
+
+// mesh and buffers kept by each thread of a sweep
+typedef struct _tSweepWorkspace
+{
+    tFinParameters fin; // the one mesh was built with
+    tMeshData data;
+    std::unique_ptr<Mesh> mesh;
+    DoubleVector T;
+} tSweepWorkspace;
+
+
+static bool sameGeometry (const tFinParameters &a, const tFinParameters &b)
+{
+    return a.Ra == b.Ra and a.Rb == b.Rb and a.e == b.e and a.n_elms == b.n_elms;
+}
+
+
+static void solveFin (tSweepWorkspace &workspace, const tFinParameters &fin,
+                      void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                      double tolerance, tSweepResult &result)
+{
+    buildCylindricalFinMesh(workspace.data, fin);
+
+    if (workspace.mesh and sameGeometry(workspace.fin, fin))
+    {
+        workspace.mesh->setNodeData(workspace.data.volms_data);
+        workspace.mesh->setBoundaryData(workspace.data.boundary_data);
+    }
+    else
+    {
+        workspace.mesh.reset(new Mesh(&workspace.data));
+    }
+
+    workspace.fin = fin;
+
+    // a T of the right size is taken as initial guess
+    if (workspace.T.size() != fin.n_elms)
+        workspace.T.clear();
+
+    workspace.mesh->solveMesh(solver, workspace.T, tolerance);
+
+    // conduction from the tube into the first volume
+    double delta_r = (fin.Rb-fin.Ra)/fin.n_elms;
+    double S = 2*M_PI*fin.Ra*fin.e;
+
+    result.T = workspace.T;
+    result.heat = fin.lambda*S*(fin.Ta - workspace.T[0])/(delta_r/2);
+    result.efficiency = result.heat/(fin.alpha*2*M_PI*(fin.Rb*fin.Rb - fin.Ra*fin.Ra)*
+                                     (fin.Ta - fin.Tg));
+}
+
+
+void runFinSweep (const std::vector<tFinParameters> &cases,
+                  void(*solver)(const tSparseSystem&, DoubleVector&, double, bool),
+                  double tolerance,
+                  const std::function<void(const tSweepResult&)> &on_result)
+{
+    ThreadPool &pool = defaultThreadPool();
+    std::vector<tSweepWorkspace> workspaces(pool.getNumThreads());
+    std::mutex output_mutex;
+
+    pool.parallelTasks(cases.size(), [&] (int thread, int i)
+    {
+        tSweepResult result;
+
+        result.index = i;
+        result.fin = cases[i];
+        result.heat = 0;
+        result.efficiency = 0;
+
+        // exceptions can not leave the threads of the pool
+        try
+        {
+            solveFin(workspaces[thread], cases[i], solver, tolerance, result);
+        }
+        catch (std::exception &exception)
+        {
+            result.error = exception.what();
+            workspaces[thread].mesh.reset();
+        }
+
+        std::unique_lock<std::mutex> lock(output_mutex);
+        on_result(result);
+    });
+}
@@ -0,0 +1,238 @@
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool (int n_threads) :
+        job_id_(0), busy_workers_(0), stop_(false), running_(false),
+        body_(nullptr), task_(false), n_(0), chunk_size_(1), next_chunk_(0),
+        task_ranges_(n_threads > 1 ? n_threads : 1)
+{
+    for (int i = 1; i < n_threads; i++)
+        workers_.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+
+int ThreadPool::getNumThreads () const
+{
+    return workers_.size() + 1;
+}
+
+
+void ThreadPool::parallelFor (int n, int chunk_size,
+                              const std::function<void(int,int)> &body)
+{
+    if (chunk_size < 1)
+        chunk_size = 1;
+
+    run(n, chunk_size, body, false);
+}
+
+
+void ThreadPool::parallelTasks (int n, const std::function<void(int,int)> &body)
+{
+    run(n, 1, body, true);
+}
+
+
+void ThreadPool::run (int n, int chunk_size,
+                      const std::function<void(int,int)> &body, bool task)
+{
+    if (n <= 0)
+        return;
+
+    bool idle = false;
+
+    // not worth waking up the workers for a single chunk, and they can not
+    // take a second loop while running one
+    if (workers_.empty() or n <= chunk_size or
+        not running_.compare_exchange_strong(idle, true))
+    {
+        if (task)
+        {
+            for (int i = 0; i < n; i++)
+                body(0, i);
+        }
+        else
+        {
+            body(0, n);
+        }
+
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        body_ = &body;
+        task_ = task;
+        n_ = n;
+        chunk_size_ = chunk_size;
+        next_chunk_ = 0;
+        busy_workers_ = workers_.size();
+        job_id_++;
+
+        if (task)
+        {
+            int n_threads = task_ranges_.size();
+
+            for (int t = 0; t < n_threads; t++)
+            {
+                std::unique_lock<std::mutex> range_lock(task_ranges_[t].mutex);
+                task_ranges_[t].begin = (long(n)*t)/n_threads;
+                task_ranges_[t].end = (long(n)*(t+1))/n_threads;
+            }
+        }
+    }
+
+    job_ready_.notify_all();
+
+    if (task)
+        runTasks(0);
+    else
+        runChunks(0);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        job_done_.wait(lock, [this] { return busy_workers_ == 0; });
+        body_ = nullptr;
+    }
+
+    running_ = false;
+}
+
+
+void ThreadPool::workerLoop (int thread)
+{
+    unsigned long last_job = 0;
+
+    while (true)
+    {
+        bool task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job_ready_.wait(lock, [&] { return stop_ or job_id_ != last_job; });
+
+            if (stop_)
+                return;
+
+            last_job = job_id_;
+            task = task_;
+        }
+
+        if (task)
+            runTasks(thread);
+        else
+            runChunks(thread);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            busy_workers_--;
+        }
+
+        job_done_.notify_one();
+    }
+}
+
+
+void ThreadPool::runChunks (int thread)
+{
+    while (true)
+    {
+        int begin = chunk_size_*(next_chunk_++);
+
+        if (begin >= n_)
+            return;
+
+        int end = begin + chunk_size_;
+
+        (*body_)(begin, end < n_ ? end : n_);
+    }
+}
+
+
+void ThreadPool::runTasks (int thread)
+{
+    int n_threads = task_ranges_.size();
+    tTaskRange &own = task_ranges_[thread];
+
+    while (true)
+    {
+        int i = -1;
+
+        {
+            std::unique_lock<std::mutex> lock(own.mutex);
+
+            if (own.begin < own.end)
+                i = own.begin++;
+        }
+
+        if (i < 0)
+        {
+            // steal from the thread with most iterations left. The ones taken
+            // are in no range until they are stored in own, but this thread
+            // runs them anyway, so the others can stop if they see none left
+            int victim = -1;
+            int most_left = 0;
+
+            for (int t = 0; t < n_threads; t++)
+            {
+                std::unique_lock<std::mutex> lock(task_ranges_[t].mutex);
+                int left = task_ranges_[t].end - task_ranges_[t].begin;
+
+                if (left > most_left)
+                {
+                    most_left = left;
+                    victim = t;
+                }
+            }
+
+            if (victim < 0)
+                return;
+
+            int begin, end;
+
+            {
+                std::unique_lock<std::mutex> lock(task_ranges_[victim].mutex);
+                int left = task_ranges_[victim].end - task_ranges_[victim].begin;
+
+                // someone else emptied it in the meantime
+                if (left <= 0)
+                    continue;
+
+                end = task_ranges_[victim].end;
+                begin = end - (left+1)/2;
+                task_ranges_[victim].end = begin;
+            }
+
+            i = begin;
+
+            std::unique_lock<std::mutex> lock(own.mutex);
+            own.begin = begin + 1;
+            own.end = end;
+        }
+
+        (*body_)(thread, i);
+    }
+}
+
+
+ThreadPool::~ThreadPool ()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    job_ready_.notify_all();
+
+    for (int i = 0; i < workers_.size(); i++)
+        workers_[i].join();
+}
+
+
+ThreadPool& defaultThreadPool ()
+{
+    static ThreadPool pool(std::thread::hardware_concurrency() > 0 ?
+                           std::thread::hardware_concurrency() : 1);
+    return pool;
+}
@@ -0,0 +1,199 @@
+#include "transient_sink.h"
+#include <algorithm>
+#include "exceptions.h"
+
+
+MatrixSink::MatrixSink (DoubleMatrix &T, DoubleVector *times) :
+        T_(T), times_(times), next_(0)
+{
+}
+
+
+void MatrixSink::begin (int n_nodes, int n_snapshots)
+{
+    T_.resize(n_snapshots);
+
+    for (int s = 0; s < T_.size(); s++)
+        T_[s].resize(n_nodes);
+
+    if (times_ != nullptr)
+        times_->resize(n_snapshots);
+
+    next_ = 0;
+}
+
+
+void MatrixSink::store (double time, const DoubleVector &T)
+{
+    std::copy(T.begin(), T.end(), T_[next_].begin());
+
+    if (times_ != nullptr)
+        (*times_)[next_] = time;
+
+    next_++;
+}
+
+
+AsyncSink::AsyncSink (TransientSink &sink, int max_pending) :
+        sink_(sink), max_pending_(max_pending > 1 ? max_pending : 1),
+        finished_(false)
+{
+}
+
+
+void AsyncSink::begin (int n_nodes, int n_snapshots)
+{
+    stop();
+
+    sink_.begin(n_nodes, n_snapshots);
+
+    finished_ = false;
+    error_ = nullptr;
+    writer_ = std::thread(&AsyncSink::writerLoop, this);
+}
+
+
+void AsyncSink::store (double time, const DoubleVector &T)
+{
+    // without the thread nothing would take the snapshots
+    if (not writer_.joinable())
+        throw SinkNotStarted();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return pending_.size() < max_pending_ or error_; });
+
+    if (error_)
+    {
+        lock.unlock();
+        rethrow();
+    }
+
+    DoubleVector buffer;
+
+    if (not free_.empty())
+    {
+        buffer.swap(free_.back());
+        free_.pop_back();
+    }
+
+    buffer.assign(T.begin(), T.end());
+
+    pending_times_.push_back(time);
+    pending_.push_back(DoubleVector());
+    pending_.back().swap(buffer);
+
+    changed_.notify_all();
+}
+
+
+void AsyncSink::writerLoop ()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true)
+    {
+        changed_.wait(lock, [this] { return not pending_.empty() or finished_; });
+
+        if (pending_.empty())
+            return;
+
+        // the snapshot keeps its place in the queue while it is written, so it
+        // still counts as pending
+        double time = pending_times_.front();
+        DoubleVector snapshot;
+        snapshot.swap(pending_.front());
+
+        lock.unlock();
+
+        bool failed = false;
+
+        try
+        {
+            sink_.store(time, snapshot);
+        }
+        catch (...)
+        {
+            failed = true;
+            lock.lock();
+            error_ = std::current_exception();
+        }
+
+        if (not failed)
+            lock.lock();
+
+        pending_times_.erase(pending_times_.begin());
+        pending_.erase(pending_.begin());
+        free_.push_back(DoubleVector());
+        free_.back().swap(snapshot);
+
+        changed_.notify_all();
+
+        if (failed)
+            return;
+    }
+}
+
+
+void AsyncSink::flush ()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // without the thread there is nothing pending
+    if (writer_.joinable())
+        changed_.wait(lock, [this] { return pending_.empty() or error_; });
+
+    if (error_)
+    {
+        lock.unlock();
+        rethrow();
+    }
+
+    sink_.flush();
+}
+
+
+void AsyncSink::stop ()
+{
+    if (not writer_.joinable())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+
+    changed_.notify_all();
+    writer_.join();
+
+    // snapshots left after an error are dropped
+    pending_times_.clear();
+    pending_.clear();
+}
+
+
+void AsyncSink::rethrow ()
+{
+    stop();
+
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+
+    std::rethrow_exception(error);
+}
+
+
+void AsyncSink::end ()
+{
+    stop();
+
+    if (error_)
+        rethrow();
+
+    sink_.end();
+}
+
+
+AsyncSink::~AsyncSink ()
+{
+    stop();
+}